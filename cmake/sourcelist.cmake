@@ -3,13 +3,27 @@ set(SOURCES
 	src/Menus/ContainerMenu/BarterMenu.h
 	src/Menus/ContainerMenu/ContainerMenu.h
 	src/Menus/HUDMenuEx/HUDMenuEx.h
+	src/Menus/LevelUpMenu/ConditionProgram.h
 	src/Menus/LevelUpMenu/LevelUpMenu.h
+	src/Menus/LevelUpMenu/PerkGraph.h
+	src/Menus/LevelUpMenu/PerkIconCache.h
 	src/Menus/LevelUpMenu/PerkManager.h
+	src/Menus/LevelUpMenu/TextArena.h
 	src/Menus/Menus.h
 	src/Menus/PipboyMenu/PipboyManager.h
+	src/Menus/PluginExplorerMenu/FormIndex.h
+	src/Menus/PluginExplorerMenu/FormIndexCache.h
+	src/Menus/PluginExplorerMenu/FormIndexExport.h
+	src/Menus/PluginExplorerMenu/FormLabel.h
+	src/Menus/PluginExplorerMenu/FormQuery.h
+	src/Menus/PluginExplorerMenu/FormRegistry.h
+	src/Menus/PluginExplorerMenu/FormSearch.h
+	src/Menus/PluginExplorerMenu/NameScanner.h
 	src/Menus/PluginExplorerMenu/PluginExplorer.h
 	src/Menus/PluginExplorerMenu/PluginExplorerMenu.h
 	src/Menus/Scaleform/Log.h
+	src/Menus/Utils/CpuFeatures/CpuFeatures.h
+	src/Menus/Utils/Fingerprint/Fingerprint.h
 	src/Menus/Utils/InventoryItemDisplayData/InventoryItemDisplayData.h
 	src/Menus/Utils/ItemCard/ItemCard.h
 	src/Menus/Utils/Utils.h
@@ -0,0 +1,431 @@
+// Test and benchmark for ConditionProgram against the menu's original condition evaluator, run off the game machine.
+// Build with: g++ -std=c++20 -O2 -o condition_program_test condition_program_test.cpp
+//
+// Usage:
+//   condition_program_test [lists] [passes]    random lists checked and timed after the fixed cases
+//
+// The reference walks each condition list with branches, the way the engine does: a condition flagged OR forms a group
+// with the conditions after it up to the first one that is not flagged, a group holds if any of its conditions does,
+// and the list holds if every group does. A rank is hidden when a sex or global condition fails, and conditions on
+// functions the menu does not describe always hold. The program, with validity read off its sex and global results the
+// way PerkManager does, has to agree with it on every list and on every single condition. Lists without OR flags also
+// have to come out as they did from PerkConditions as the menu first shipped it, which required every condition.
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "../src/Menus/LevelUpMenu/ConditionProgram.h"
+
+namespace
+{
+	using Op = Menus::ConditionProgram::Op;
+
+	// Listed conditions are the ones shown in the text, blank ones are sex and global conditions, unchecked ones are
+	// on functions the menu does not describe
+	enum class Kind
+	{
+		kListed,
+		kBlank,
+		kUnchecked
+	};
+
+	struct Condition
+	{
+		std::uint32_t slot;
+		Op op;
+		float value;
+		bool isOr;
+		Kind kind{ Kind::kListed };
+	};
+
+	using List = std::vector<Condition>;
+
+	struct Outcome
+	{
+		bool isValid;
+		bool isAvailable;
+	};
+
+	bool Compare(float a_lhs, Op a_op, float a_rhs)
+	{
+		switch (a_op)
+		{
+			case Op::kEqual:
+				return a_lhs == a_rhs;
+			case Op::kNotEqual:
+				return a_lhs != a_rhs;
+			case Op::kGreater:
+				return a_lhs > a_rhs;
+			case Op::kGreaterEqual:
+				return a_lhs >= a_rhs;
+			case Op::kLess:
+				return a_lhs < a_rhs;
+			case Op::kLessEqual:
+				return a_lhs <= a_rhs;
+			default:
+				return true;
+		}
+	}
+
+	bool IsTrue(const Condition& a_condition, std::span<const float> a_snapshot)
+	{
+		return a_condition.kind == Kind::kUnchecked || Compare(a_snapshot[a_condition.slot], a_condition.op, a_condition.value);
+	}
+
+	// PerkCondition and PerkConditions from the first version of PerkManager, with IsTrue on the game replaced by
+	// Compare on the snapshot. A blank condition that fails makes the whole list invalid, and only conditions that are
+	// listed ever make it unavailable.
+	Outcome Original(const List& a_list, std::span<const float> a_snapshot)
+	{
+		Outcome result{ true, true };
+		for (auto& condition : a_list)
+		{
+			auto isTrue{ true };
+			auto isValid{ true };
+			switch (condition.kind)
+			{
+				case Kind::kListed:
+					isTrue = Compare(a_snapshot[condition.slot], condition.op, condition.value);
+					break;
+				case Kind::kBlank:
+					isValid = Compare(a_snapshot[condition.slot], condition.op, condition.value);
+					break;
+				default:
+					break;
+			}
+
+			if (!isValid)
+			{
+				result.isValid = false;
+				return result;
+			}
+
+			if (!isTrue)
+			{
+				result.isAvailable = false;
+			}
+		}
+
+		return result;
+	}
+
+	Outcome Reference(const List& a_list, std::span<const float> a_snapshot)
+	{
+		Outcome result{ true, true };
+		bool group{ false };
+		for (std::size_t i = 0; i < a_list.size(); i++)
+		{
+			auto& condition = a_list[i];
+			auto isTrue = IsTrue(condition, a_snapshot);
+			if (condition.kind == Kind::kBlank && !isTrue)
+			{
+				result.isValid = false;
+			}
+
+			group = group || isTrue;
+			if (!condition.isOr || i + 1 == a_list.size())
+			{
+				result.isAvailable = result.isAvailable && group;
+				group = false;
+			}
+		}
+
+		return result;
+	}
+
+	struct Compiled
+	{
+		Menus::ConditionProgram program;
+		std::vector<std::uint32_t> blocks;
+		std::vector<std::vector<std::uint32_t>> instructions;
+	};
+
+	Compiled Compile(const std::vector<List>& a_lists)
+	{
+		Compiled result;
+		for (auto& list : a_lists)
+		{
+			result.blocks.push_back(result.program.AddBlock());
+			auto& instructions = result.instructions.emplace_back();
+			for (auto& condition : list)
+			{
+				auto op = (condition.kind == Kind::kUnchecked) ? Op::kTrue : condition.op;
+				instructions.push_back(result.program.Add(condition.slot, op, condition.value, condition.isOr));
+			}
+		}
+
+		return result;
+	}
+
+	// What PerkConditions reads off the results: IsValid from its blank conditions, IsTrue from its block
+	Outcome Evaluate(const Compiled& a_compiled, const Menus::ConditionProgram::Results& a_results, const List& a_list, std::size_t a_index)
+	{
+		Outcome result{ true, static_cast<bool>(a_results.blocks[a_compiled.blocks[a_index]]) };
+		for (std::size_t i = 0; i < a_list.size(); i++)
+		{
+			if (a_list[i].kind == Kind::kBlank && !a_results.conditions[a_compiled.instructions[a_index][i]])
+			{
+				result.isValid = false;
+			}
+		}
+
+		return result;
+	}
+
+	// Availability is only compared on valid lists, the menu never shows it for the others
+	bool Matches(const Outcome& a_actual, const Outcome& a_expected)
+	{
+		return a_actual.isValid == a_expected.isValid && (!a_expected.isValid || a_actual.isAvailable == a_expected.isAvailable);
+	}
+
+	bool HasOr(const List& a_list)
+	{
+		return std::ranges::any_of(a_list, [](const Condition& a_condition) { return a_condition.isOr; });
+	}
+
+	// Returns the number of lists or conditions that differ from the reference, and from the original evaluator on
+	// lists without OR flags
+	std::size_t Check(const std::vector<List>& a_lists, std::span<const float> a_snapshot)
+	{
+		auto compiled = Compile(a_lists);
+		Menus::ConditionProgram::Results results;
+		compiled.program.Run(a_snapshot, results);
+
+		std::size_t mismatches{ 0 };
+		for (std::size_t i = 0; i < a_lists.size(); i++)
+		{
+			auto outcome = Evaluate(compiled, results, a_lists[i], i);
+			if (!Matches(outcome, Reference(a_lists[i], a_snapshot)))
+			{
+				mismatches++;
+			}
+
+			if (!HasOr(a_lists[i]) && !Matches(outcome, Original(a_lists[i], a_snapshot)))
+			{
+				mismatches++;
+			}
+
+			for (std::size_t j = 0; j < a_lists[i].size(); j++)
+			{
+				auto& condition = a_lists[i][j];
+				if (static_cast<bool>(results.conditions[compiled.instructions[i][j]]) != IsTrue(condition, a_snapshot))
+				{
+					mismatches++;
+				}
+			}
+		}
+
+		return mismatches;
+	}
+
+	int failures{ 0 };
+
+	void Expect(const char* a_name, const List& a_list, std::span<const float> a_snapshot, Outcome a_expected)
+	{
+		auto compiled = Compile({ a_list });
+		Menus::ConditionProgram::Results results;
+		compiled.program.Run(a_snapshot, results);
+
+		auto actual = Evaluate(compiled, results, a_list, 0);
+		auto reference = Reference(a_list, a_snapshot);
+		if (!Matches(actual, a_expected) || !Matches(reference, a_expected))
+		{
+			std::printf(
+				"FAIL %s: program %d/%d, reference %d/%d, expected %d/%d\n",
+				a_name,
+				actual.isValid,
+				actual.isAvailable,
+				reference.isValid,
+				reference.isAvailable,
+				a_expected.isValid,
+				a_expected.isAvailable);
+			failures++;
+		}
+	}
+
+	void RunFixedCases()
+	{
+		// Slot 0 holds 0, slot 1 holds 1, slot 2 holds NaN
+		const float snapshot[]{ 0.0F, 1.0F, std::numeric_limits<float>::quiet_NaN() };
+		const Condition yes{ 1, Op::kEqual, 1.0F, false };
+		const Condition no{ 0, Op::kEqual, 1.0F, false };
+		auto Or = [](Condition a_condition)
+		{
+			a_condition.isOr = true;
+			return a_condition;
+		};
+		auto As = [](Kind a_kind, Condition a_condition)
+		{
+			a_condition.kind = a_kind;
+			return a_condition;
+		};
+
+		constexpr Outcome AVAILABLE{ true, true };
+		constexpr Outcome UNAVAILABLE{ true, false };
+		constexpr Outcome HIDDEN{ false, false };
+
+		Expect("empty list holds", {}, snapshot, AVAILABLE);
+		Expect("single true", { yes }, snapshot, AVAILABLE);
+		Expect("single false", { no }, snapshot, UNAVAILABLE);
+		Expect("every condition is required", { yes, no }, snapshot, UNAVAILABLE);
+		Expect("every condition holds", { yes, yes, yes }, snapshot, AVAILABLE);
+		Expect("false OR true", { Or(no), yes }, snapshot, AVAILABLE);
+		Expect("true OR false", { Or(yes), no }, snapshot, AVAILABLE);
+		Expect("false OR false", { Or(no), no }, snapshot, UNAVAILABLE);
+		Expect("(false OR true) AND false", { Or(no), yes, no }, snapshot, UNAVAILABLE);
+		Expect("(false OR true) AND true", { Or(no), yes, yes }, snapshot, AVAILABLE);
+		Expect("true AND (false OR true)", { yes, Or(no), yes }, snapshot, AVAILABLE);
+		Expect("false AND (true OR true)", { no, Or(yes), yes }, snapshot, UNAVAILABLE);
+		Expect("OR binds tighter than AND", { Or(no), no, Or(yes), yes }, snapshot, UNAVAILABLE);
+		Expect("three-way OR group", { Or(no), Or(no), yes }, snapshot, AVAILABLE);
+		Expect("OR on the last condition is ignored", { yes, Or(no) }, snapshot, UNAVAILABLE);
+		Expect("OR on the last condition is ignored when true", { no, Or(yes) }, snapshot, UNAVAILABLE);
+
+		Expect("failed blank hides the list", { yes, As(Kind::kBlank, no) }, snapshot, HIDDEN);
+		Expect("held blank does not count", { no, As(Kind::kBlank, yes) }, snapshot, UNAVAILABLE);
+		Expect("failed blank hides an available list", { As(Kind::kBlank, no), yes }, snapshot, HIDDEN);
+		Expect("OR does not save a failed blank", { Or(As(Kind::kBlank, no)), yes }, snapshot, HIDDEN);
+		Expect("unchecked holds its OR group", { Or(no), As(Kind::kUnchecked, no) }, snapshot, AVAILABLE);
+		Expect("unchecked always holds", { As(Kind::kUnchecked, no), yes }, snapshot, AVAILABLE);
+
+		Expect("NaN is not equal", { { 2, Op::kEqual, 0.0F, false } }, snapshot, UNAVAILABLE);
+		Expect("NaN is unequal", { { 2, Op::kNotEqual, 0.0F, false } }, snapshot, AVAILABLE);
+		Expect("NaN is not greater", { { 2, Op::kGreater, 0.0F, false } }, snapshot, UNAVAILABLE);
+		Expect("NaN is not less or equal", { { 2, Op::kLessEqual, 0.0F, false } }, snapshot, UNAVAILABLE);
+		Expect("kTrue holds on NaN", { { 2, Op::kTrue, 0.0F, false } }, snapshot, AVAILABLE);
+
+		// Groups never span lists, even when the last condition of a list is flagged OR
+		std::vector<List> lists{ { yes, Or(no) }, { yes }, { Or(no) }, { no }, { As(Kind::kBlank, no) }, { yes } };
+		if (auto mismatches = Check(lists, snapshot); mismatches != 0)
+		{
+			std::printf("FAIL groups span lists: %zu mismatches\n", mismatches);
+			failures++;
+		}
+	}
+
+	std::vector<List> Generate(std::size_t a_lists, std::size_t a_slots, std::mt19937& a_rng)
+	{
+		std::vector<List> result(a_lists);
+		for (auto& list : result)
+		{
+			list.resize(a_rng() % 6);
+			for (auto& condition : list)
+			{
+				condition.slot = static_cast<std::uint32_t>(a_rng() % a_slots);
+				condition.op = static_cast<Op>(a_rng() % 7);
+				condition.value = static_cast<float>(a_rng() % 5);
+				condition.isOr = (a_rng() % 3 == 0);
+				condition.kind = static_cast<Kind>((a_rng() % 8 < 6) ? 0 : 1 + a_rng() % 2);
+			}
+		}
+
+		return result;
+	}
+
+	std::vector<float> Snapshot(std::size_t a_slots, std::mt19937& a_rng)
+	{
+		std::vector<float> result(a_slots);
+		for (auto& value : result)
+		{
+			value = (a_rng() % 16 == 0) ? std::numeric_limits<float>::quiet_NaN() : static_cast<float>(a_rng() % 5);
+		}
+
+		return result;
+	}
+
+	template<class FUNC>
+	double Time(int a_passes, FUNC a_func)
+	{
+		double best{ 0.0 };
+		for (int pass = 0; pass < a_passes; pass++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			a_func();
+			auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			best = (pass == 0) ? seconds : std::min(best, seconds);
+		}
+
+		return best;
+	}
+
+	void RunRandomCases(std::size_t a_lists, int a_passes)
+	{
+		constexpr std::size_t SLOTS{ 64 };
+
+		std::mt19937 rng{ 1 };
+		auto lists = Generate(a_lists, SLOTS, rng);
+		std::size_t conditions{ 0 };
+		for (auto& list : lists)
+		{
+			conditions += list.size();
+		}
+
+		std::size_t mismatches{ 0 };
+		std::size_t regrouped{ 0 };
+		for (int round = 0; round < 20; round++)
+		{
+			auto snapshot = Snapshot(SLOTS, rng);
+			mismatches += Check(lists, snapshot);
+			for (auto& list : lists)
+			{
+				auto grouped = Reference(list, snapshot);
+				regrouped += grouped.isValid && grouped.isAvailable != Original(list, snapshot).isAvailable;
+			}
+		}
+
+		std::printf(
+			"random: %zu lists, %zu conditions, 20 snapshots: %zu mismatches, %zu outcomes changed by OR grouping\n",
+			lists.size(),
+			conditions,
+			mismatches,
+			regrouped);
+		if (mismatches != 0)
+		{
+			failures++;
+		}
+
+		auto compiled = Compile(lists);
+		auto snapshot = Snapshot(SLOTS, rng);
+		Menus::ConditionProgram::Results results;
+		std::size_t count{ 0 };
+		auto programSeconds = Time(
+			a_passes,
+			[&]()
+			{
+				compiled.program.Run(snapshot, results);
+				count += std::count(results.blocks.begin(), results.blocks.end(), std::uint8_t{ 1 });
+			});
+		auto referenceSeconds = Time(
+			a_passes,
+			[&]()
+			{
+				for (auto& list : lists)
+				{
+					count += Reference(list, snapshot).isAvailable;
+				}
+			});
+
+		std::printf("bench: program %.1fus, reference %.1fus per pass (checksum %zu)\n", programSeconds * 1e6, referenceSeconds * 1e6, count);
+	}
+}
+
+int main(int a_argc, char** a_argv)
+{
+	auto lists = (a_argc > 1) ? std::strtoull(a_argv[1], nullptr, 10) : 100000;
+	auto passes = (a_argc > 2) ? std::max(std::atoi(a_argv[2]), 1) : 10;
+
+	RunFixedCases();
+	RunRandomCases(lists, passes);
+
+	std::printf(failures ? "%d FAILED\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,365 @@
+// Reader and benchmark for the binary PluginExplorer export, for auditing load orders off the game machine.
+// Build with: g++ -std=c++20 -O2 -o explorer_export_reader explorer_export_reader.cpp
+//
+// Usage:
+//   explorer_export_reader summary <file>               per-plugin and per-category form counts
+//   explorer_export_reader dump <file>                  every record as tab-separated text
+//   explorer_export_reader bench <file> [passes]        parse throughput, reading the file in fixed-size blocks
+//   explorer_export_reader generate <file> <records>    writes a synthetic export to benchmark against
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	constexpr std::uint32_t MAGIC{ 'B' | ('K' << 8) | ('E' << 16) | ('X' << 24) };
+	constexpr std::uint32_t VERSION{ 1 };
+	constexpr std::size_t BUFFER_SIZE{ 0x10000 };
+
+	// Pulls the file through a fixed-size buffer, so memory use does not depend on the size of the export
+	class Reader
+	{
+	public:
+		explicit Reader(const char* a_path) :
+			fd(::open(a_path, O_RDONLY))
+		{
+			if (fd < 0)
+			{
+				throw std::runtime_error(std::string{ "cannot open " } + a_path);
+			}
+		}
+
+		Reader(const Reader&) = delete;
+		Reader& operator=(const Reader&) = delete;
+
+		~Reader() { ::close(fd); }
+
+		[[nodiscard]] bool AtEnd()
+		{
+			return pos == size && !Fill();
+		}
+
+		void Read(void* a_data, std::size_t a_size)
+		{
+			auto bytes = static_cast<char*>(a_data);
+			while (a_size > 0)
+			{
+				if (pos == size && !Fill())
+				{
+					throw std::runtime_error("unexpected end of file");
+				}
+
+				auto count = std::min(a_size, size - pos);
+				std::memcpy(bytes, buffer.data() + pos, count);
+				pos += count;
+				bytes += count;
+				a_size -= count;
+			}
+		}
+
+		template<class T>
+		T ReadValue()
+		{
+			T value;
+			Read(&value, sizeof(value));
+			return value;
+		}
+
+		std::string_view ReadString(std::string& a_storage)
+		{
+			a_storage.resize(ReadValue<std::uint16_t>());
+			Read(a_storage.data(), a_storage.size());
+			return a_storage;
+		}
+
+		[[nodiscard]] std::uint64_t GetByteCount() const noexcept { return consumed - (size - pos); }
+
+	private:
+		bool Fill()
+		{
+			auto count = ::read(fd, buffer.data(), buffer.size());
+			if (count < 0)
+			{
+				throw std::runtime_error("read failed");
+			}
+
+			pos = 0;
+			size = static_cast<std::size_t>(count);
+			consumed += size;
+			return size > 0;
+		}
+
+		int fd{ -1 };
+		std::array<char, BUFFER_SIZE> buffer{};
+		std::size_t pos{ 0 };
+		std::size_t size{ 0 };
+		std::uint64_t consumed{ 0 };
+	};
+
+	struct Record
+	{
+		std::uint32_t formID;
+		std::uint16_t plugin;
+		std::uint8_t category;
+		std::string_view name;
+	};
+
+	struct Export
+	{
+		std::vector<std::string> plugins;
+		std::vector<std::string> categories;
+		std::uint64_t recordCount{ 0 };
+	};
+
+	Export ReadHeader(Reader& a_reader)
+	{
+		if (a_reader.ReadValue<std::uint32_t>() != MAGIC || a_reader.ReadValue<std::uint32_t>() != VERSION)
+		{
+			throw std::runtime_error("not a PluginExplorer export, or an unsupported version");
+		}
+
+		Export result;
+		result.plugins.resize(a_reader.ReadValue<std::uint32_t>());
+		result.categories.resize(a_reader.ReadValue<std::uint32_t>());
+		result.recordCount = a_reader.ReadValue<std::uint64_t>();
+		for (auto& plugin : result.plugins)
+		{
+			a_reader.ReadString(plugin);
+		}
+
+		for (auto& category : result.categories)
+		{
+			a_reader.ReadString(category);
+		}
+
+		return result;
+	}
+
+	// Calls a_func for every record, checking each against the header
+	template<class FUNC>
+	void ReadRecords(Reader& a_reader, const Export& a_export, FUNC a_func)
+	{
+		std::string name;
+		Record record{};
+		for (std::uint64_t i = 0; i < a_export.recordCount; i++)
+		{
+			record.formID = a_reader.ReadValue<std::uint32_t>();
+			record.plugin = a_reader.ReadValue<std::uint16_t>();
+			record.category = a_reader.ReadValue<std::uint8_t>();
+			record.name = a_reader.ReadString(name);
+			if (record.plugin >= a_export.plugins.size() || record.category >= a_export.categories.size())
+			{
+				throw std::runtime_error("record " + std::to_string(i) + " is out of range");
+			}
+
+			a_func(record);
+		}
+
+		if (!a_reader.AtEnd())
+		{
+			throw std::runtime_error("trailing data after the last record");
+		}
+	}
+
+	int Summary(const char* a_path)
+	{
+		Reader reader{ a_path };
+		auto file = ReadHeader(reader);
+
+		std::vector<std::uint64_t> counts(file.plugins.size() * file.categories.size());
+		ReadRecords(
+			reader,
+			file,
+			[&](const Record& a_record)
+			{
+				counts[a_record.plugin * file.categories.size() + a_record.category]++;
+			});
+
+		for (std::size_t plugin = 0; plugin < file.plugins.size(); plugin++)
+		{
+			std::uint64_t total{ 0 };
+			std::string line;
+			for (std::size_t category = 0; category < file.categories.size(); category++)
+			{
+				if (auto count = counts[plugin * file.categories.size() + category]; count)
+				{
+					line += " " + file.categories[category] + "=" + std::to_string(count);
+					total += count;
+				}
+			}
+
+			if (total)
+			{
+				std::printf("%s: %llu%s\n", file.plugins[plugin].c_str(), static_cast<unsigned long long>(total), line.c_str());
+			}
+		}
+
+		std::printf("%llu forms from %zu plugins\n", static_cast<unsigned long long>(file.recordCount), file.plugins.size());
+		return 0;
+	}
+
+	int Dump(const char* a_path)
+	{
+		Reader reader{ a_path };
+		auto file = ReadHeader(reader);
+		ReadRecords(
+			reader,
+			file,
+			[&](const Record& a_record)
+			{
+				std::printf(
+					"%s\t%s\t%08X\t%.*s\n",
+					file.plugins[a_record.plugin].c_str(),
+					file.categories[a_record.category].c_str(),
+					a_record.formID,
+					static_cast<int>(a_record.name.size()),
+					a_record.name.data());
+			});
+		return 0;
+	}
+
+	int Bench(const char* a_path, int a_passes)
+	{
+		double best{ 0.0 };
+		std::uint64_t records{ 0 };
+		std::uint64_t bytes{ 0 };
+		for (int pass = 0; pass < a_passes; pass++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			Reader reader{ a_path };
+			auto file = ReadHeader(reader);
+
+			std::uint64_t checksum{ 0 };
+			ReadRecords(
+				reader,
+				file,
+				[&](const Record& a_record)
+				{
+					checksum += a_record.formID + a_record.name.size();
+				});
+
+			auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			best = (pass == 0) ? seconds : std::min(best, seconds);
+			records = file.recordCount;
+			bytes = reader.GetByteCount();
+			std::printf("pass %d: %.1fms (checksum %llu)\n", pass + 1, seconds * 1e3, static_cast<unsigned long long>(checksum));
+		}
+
+		std::printf(
+			"%llu records, %llu bytes: best %.1fms, %.1fM records/s, %.0fMB/s\n",
+			static_cast<unsigned long long>(records),
+			static_cast<unsigned long long>(bytes),
+			best * 1e3,
+			records / best / 1e6,
+			bytes / best / 1e6);
+		return 0;
+	}
+
+	int Generate(const char* a_path, std::uint64_t a_records)
+	{
+		std::FILE* file = std::fopen(a_path, "wb");
+		if (!file)
+		{
+			throw std::runtime_error(std::string{ "cannot create " } + a_path);
+		}
+
+		auto Write = [&](const void* a_data, std::size_t a_size)
+		{
+			std::fwrite(a_data, 1, a_size, file);
+		};
+
+		auto WriteString = [&](std::string_view a_string)
+		{
+			auto size = static_cast<std::uint16_t>(a_string.size());
+			Write(&size, sizeof(size));
+			Write(a_string.data(), size);
+		};
+
+		constexpr std::array<std::string_view, 15> CATEGORIES{
+			"ALCH", "AMMO", "ARMO", "BOOK", "FLOR", "HOLO", "INGR", "JUNK", "KEYS", "LVLI", "MISC", "MODS", "NPC_", "OMOD", "WEAP"
+		};
+		constexpr std::uint32_t PLUGIN_COUNT{ 256 };
+
+		std::uint32_t header[]{ MAGIC, VERSION, PLUGIN_COUNT, static_cast<std::uint32_t>(CATEGORIES.size()) };
+		Write(header, sizeof(header));
+		Write(&a_records, sizeof(a_records));
+		for (std::uint32_t plugin = 0; plugin < PLUGIN_COUNT; plugin++)
+		{
+			WriteString("Plugin" + std::to_string(plugin) + ".esp");
+		}
+
+		for (auto category : CATEGORIES)
+		{
+			WriteString(category);
+		}
+
+		std::mt19937 rng{ 1 };
+		for (std::uint64_t i = 0; i < a_records; i++)
+		{
+			auto plugin = static_cast<std::uint16_t>(i * PLUGIN_COUNT / a_records);
+			auto category = static_cast<std::uint8_t>(rng() % CATEGORIES.size());
+			auto formID = static_cast<std::uint32_t>((plugin << 24) | (i & 0xFFFFFF));
+			Write(&formID, sizeof(formID));
+			Write(&plugin, sizeof(plugin));
+			Write(&category, sizeof(category));
+			WriteString("Generated Form " + std::to_string(rng() % 100000));
+		}
+
+		std::fclose(file);
+		return 0;
+	}
+}
+
+int main(int a_argc, char** a_argv)
+{
+	if (a_argc < 3)
+	{
+		std::fprintf(stderr, "usage: %s summary|dump|bench|generate <file> [passes|records]\n", a_argv[0]);
+		return 1;
+	}
+
+	try
+	{
+		std::string_view command{ a_argv[1] };
+		if (command == "summary")
+		{
+			return Summary(a_argv[2]);
+		}
+
+		if (command == "dump")
+		{
+			return Dump(a_argv[2]);
+		}
+
+		if (command == "bench")
+		{
+			return Bench(a_argv[2], (a_argc > 3) ? std::max(std::atoi(a_argv[3]), 1) : 5);
+		}
+
+		if (command == "generate" && a_argc > 3)
+		{
+			return Generate(a_argv[2], std::strtoull(a_argv[3], nullptr, 10));
+		}
+
+		std::fprintf(stderr, "unknown command %s\n", a_argv[1]);
+		return 1;
+	}
+	catch (const std::exception& e)
+	{
+		std::fprintf(stderr, "%s: %s\n", a_argv[2], e.what());
+		return 1;
+	}
+}
@@ -0,0 +1,409 @@
+// Round-trip and corruption test for the PluginExplorer index cache, run off the game machine.
+// Build with: g++ -std=c++20 -O2 -I../src -o form_index_cache_test form_index_cache_test.cpp -lboost_iostreams -lfmt
+//
+// Usage:
+//   form_index_cache_test [forms] [flips]    synthetic index size and random byte flips to try, in a scratch directory
+//
+// A synthetic index is saved and mapped back through FormIndexCache, and every column, range, stat and override list
+// is compared. Damaged files are then written over the cache: each structural fault has to be rejected, and random
+// byte flips have to be either rejected or mapped into an index that reads within its bounds. Building with
+// -fsanitize=address checks the latter. The fingerprint is checked against the language and string table changes
+// that have to invalidate the cache.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <fmt/format.h>
+
+using namespace std::literals;
+
+#include "re_stubs.h"
+
+#include "../src/Menus/PluginExplorerMenu/FormIndexCache.h"
+
+namespace
+{
+	using Menus::FormCategory;
+	using Menus::FormIndex;
+	using Menus::FormIndexCache;
+	using Menus::FormStat;
+
+	constexpr std::uint32_t PLUGIN_COUNT{ 6 };
+	constexpr std::uint64_t FINGERPRINT{ 0x1234'5678'9ABC'DEF0 };
+
+	int failures{ 0 };
+
+	void Expect(bool a_condition, const char* a_name)
+	{
+		if (!a_condition)
+		{
+			std::printf("FAIL %s\n", a_name);
+			failures++;
+		}
+	}
+
+	FormIndex Generate(std::size_t a_forms, std::vector<std::string>& a_names)
+	{
+		std::mt19937 rng{ 9 };
+		a_names.resize(a_forms);
+		for (auto& name : a_names)
+		{
+			name.resize(rng() % 24, 'a');
+			for (auto& c : name)
+			{
+				c = static_cast<char>('a' + rng() % 26);
+			}
+		}
+
+		FormIndex::Builder builder;
+		for (std::size_t i = 0; i < a_forms; i++)
+		{
+			auto plugin = static_cast<std::uint32_t>(rng() % PLUGIN_COUNT);
+			std::vector<std::uint32_t> overrides;
+			for (auto later = plugin + 1; later < PLUGIN_COUNT; later++)
+			{
+				if (rng() % 4 == 0)
+				{
+					overrides.push_back(later);
+				}
+			}
+
+			// Forms without a rating store NaN, which has to survive the round trip as well
+			Menus::FormStats stats{ static_cast<float>(rng() % 1000), static_cast<float>(rng() % 100) / 10.0F, static_cast<float>(rng() % 50) };
+			if (rng() % 3 == 0)
+			{
+				stats[stl::to_underlying(FormStat::kRating)] = std::numeric_limits<float>::quiet_NaN();
+			}
+
+			builder.Add(static_cast<FormCategory>(rng() % FormIndex::CATEGORY_COUNT), plugin, (plugin << 24) | static_cast<std::uint32_t>(i), a_names[i], stats, overrides);
+		}
+
+		return builder.Build(PLUGIN_COUNT);
+	}
+
+	bool IsEqual(const FormIndex& a_lhs, const FormIndex& a_rhs)
+	{
+		if (a_lhs.GetPluginCount() != a_rhs.GetPluginCount() || a_lhs.GetFormCount() != a_rhs.GetFormCount())
+		{
+			return false;
+		}
+
+		for (std::uint32_t plugin = 0; plugin < a_lhs.GetPluginCount(); plugin++)
+		{
+			for (std::uint32_t category = 0; category < FormIndex::CATEGORY_COUNT; category++)
+			{
+				auto lhs = a_lhs.GetForms(plugin, static_cast<FormCategory>(category));
+				auto rhs = a_rhs.GetForms(plugin, static_cast<FormCategory>(category));
+				if (lhs.size() != rhs.size())
+				{
+					return false;
+				}
+
+				for (std::uint32_t pos = 0; pos < lhs.size(); pos++)
+				{
+					if (lhs[pos] != rhs[pos] || !std::ranges::equal(lhs.overrides_of(pos), rhs.overrides_of(pos)))
+					{
+						return false;
+					}
+
+					for (std::uint32_t stat = 0; stat < FormIndex::STAT_COUNT; stat++)
+					{
+						auto lhsStat = lhs.stat(static_cast<FormStat>(stat), pos);
+						auto rhsStat = rhs.stat(static_cast<FormStat>(stat), pos);
+						if (std::bit_cast<std::uint32_t>(lhsStat) != std::bit_cast<std::uint32_t>(rhsStat))
+						{
+							return false;
+						}
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// Reads everything an accepted index hands out, so a sanitizer build catches any read past the mapping
+	std::size_t Walk(const FormIndex& a_index)
+	{
+		std::size_t checksum{ 0 };
+		for (std::uint32_t plugin = 0; plugin < a_index.GetPluginCount(); plugin++)
+		{
+			for (std::uint32_t category = 0; category < FormIndex::CATEGORY_COUNT; category++)
+			{
+				auto forms = a_index.GetForms(plugin, static_cast<FormCategory>(category));
+				for (std::uint32_t pos = 0; pos < forms.size(); pos++)
+				{
+					auto [formID, name] = forms[pos];
+					checksum += formID + name.size() + forms.overrides_of(pos).size();
+					checksum += static_cast<std::size_t>(forms.stat(FormStat::kWeight, pos));
+				}
+			}
+		}
+
+		return checksum;
+	}
+
+	std::vector<char> ReadFile(const std::filesystem::path& a_path)
+	{
+		std::ifstream file{ a_path, std::ios::binary };
+		return { std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+	}
+
+	void WriteFile(const std::filesystem::path& a_path, const std::vector<char>& a_bytes)
+	{
+		std::ofstream file{ a_path, std::ios::binary | std::ios::trunc };
+		file.write(a_bytes.data(), static_cast<std::streamsize>(a_bytes.size()));
+	}
+
+	template<class T>
+	void Poke(std::vector<char>& a_bytes, std::size_t a_offset, T a_value)
+	{
+		std::memcpy(a_bytes.data() + a_offset, std::addressof(a_value), sizeof(a_value));
+	}
+
+	template<class T>
+	T Peek(const std::vector<char>& a_bytes, std::size_t a_offset)
+	{
+		T value;
+		std::memcpy(std::addressof(value), a_bytes.data() + a_offset, sizeof(value));
+		return value;
+	}
+
+	void RunRoundTrip(const FormIndex& a_index, const std::filesystem::path& a_path)
+	{
+		Expect(FormIndexCache::Save(a_path, a_index, FINGERPRINT), "save succeeds");
+		Expect(!std::filesystem::exists(a_path.string() + ".tmp"), "save leaves no temporary file");
+
+		auto loaded = FormIndexCache::Load(a_path, FINGERPRINT);
+		Expect(loaded.has_value(), "saved cache loads");
+		Expect(loaded && IsEqual(a_index, *loaded), "loaded cache matches the index it was saved from");
+		Expect(!FormIndexCache::Load(a_path, FINGERPRINT + 1), "another fingerprint is out of date");
+		Expect(!FormIndexCache::Load(a_path.string() + ".missing", FINGERPRINT), "missing cache does not load");
+
+		// Saving over an existing cache replaces it
+		FormIndex::Builder builder;
+		builder.Add(FormCategory{ 0 }, 0, 0x800, "Replacement"sv);
+		auto replacement = builder.Build(1);
+		Expect(FormIndexCache::Save(a_path, replacement, FINGERPRINT), "save over an existing cache succeeds");
+		loaded = FormIndexCache::Load(a_path, FINGERPRINT);
+		Expect(loaded && IsEqual(replacement, *loaded), "saving over a cache replaces it");
+		Expect(FormIndexCache::Save(a_path, a_index, FINGERPRINT), "save restores the original");
+	}
+
+	void RunCorruption(const std::filesystem::path& a_path, std::size_t a_flips)
+	{
+		const auto good = ReadFile(a_path);
+		using Header = FormIndex::Header;
+		auto pluginCount = Peek<std::uint32_t>(good, offsetof(Header, pluginCount));
+		auto nameBytes = Peek<std::uint64_t>(good, offsetof(Header, nameBytes));
+		auto rangesOffset = sizeof(Header);
+		auto namesOffset = good.size() - nameBytes;
+
+		struct Fault
+		{
+			const char* name;
+			std::vector<char> bytes;
+		};
+
+		std::vector<Fault> faults;
+		auto Add = [&](const char* a_name, auto a_edit)
+		{
+			auto bytes = good;
+			a_edit(bytes);
+			faults.push_back({ a_name, std::move(bytes) });
+		};
+
+		Add("empty file", [](auto& a_bytes) { a_bytes.clear(); });
+		Add("truncated header", [](auto& a_bytes) { a_bytes.resize(sizeof(Header) - 1); });
+		Add("truncated by one byte", [](auto& a_bytes) { a_bytes.pop_back(); });
+		Add("one byte too long", [](auto& a_bytes) { a_bytes.push_back('\0'); });
+		Add("bad magic", [](auto& a_bytes) { a_bytes[offsetof(Header, magic)] ^= 1; });
+		Add("other version", [](auto& a_bytes) { Poke(a_bytes, offsetof(Header, version), FormIndex::VERSION + 1); });
+		Add("other category count", [](auto& a_bytes) { Poke(a_bytes, offsetof(Header, categoryCount), FormIndex::CATEGORY_COUNT + 1); });
+		Add("column size off by one", [](auto& a_bytes) { Poke(a_bytes, offsetof(Header, columnSizes), Peek<std::uint32_t>(a_bytes, offsetof(Header, columnSizes)) + 1); });
+		Add("name bytes off by one", [&](auto& a_bytes) { Poke(a_bytes, offsetof(Header, nameBytes), nameBytes + 1); });
+		Add("huge name bytes", [](auto& a_bytes) { Poke(a_bytes, offsetof(Header, nameBytes), std::uint64_t{ 1 } << 40); });
+		Add("huge plugin count", [](auto& a_bytes) { Poke(a_bytes, offsetof(Header, pluginCount), std::numeric_limits<std::uint32_t>::max()); });
+		Add("range does not start at zero", [&](auto& a_bytes) { Poke(a_bytes, rangesOffset, std::uint32_t{ 1 }); });
+		Add("range ends before it begins", [&](auto& a_bytes) { Poke(a_bytes, rangesOffset + sizeof(std::uint32_t), std::numeric_limits<std::uint32_t>::max()); });
+		Add("last plugin range overruns the column", [&](auto& a_bytes)
+			{
+				auto offset = rangesOffset + (pluginCount - 1) * sizeof(FormIndex::RangeList) + sizeof(std::uint32_t);
+				Poke(a_bytes, offset, Peek<std::uint32_t>(a_bytes, offset) + 1);
+			});
+		Add("names not NUL terminated", [](auto& a_bytes) { a_bytes.back() = 'x'; });
+
+		// The first name offset of the first non-empty column, pointed past the arena
+		for (std::uint32_t category = 0; category < FormIndex::CATEGORY_COUNT; category++)
+		{
+			auto columnSize = Peek<std::uint32_t>(good, offsetof(Header, columnSizes) + category * sizeof(std::uint32_t));
+			if (columnSize > 1)
+			{
+				std::size_t offset{ rangesOffset + pluginCount * sizeof(FormIndex::RangeList) };
+				for (std::uint32_t before = 0; before < category; before++)
+				{
+					auto size = Peek<std::uint32_t>(good, offsetof(Header, columnSizes) + before * sizeof(std::uint32_t));
+					offset += size * 3 * sizeof(std::uint32_t) + sizeof(std::uint32_t) + size * FormIndex::STAT_COUNT * sizeof(float);
+				}
+
+				auto nameOffsets = offset + columnSize * sizeof(std::uint32_t);
+				Add("name offset past the arena", [&](auto& a_bytes) { Poke(a_bytes, nameOffsets + sizeof(std::uint32_t), static_cast<std::uint32_t>(nameBytes)); });
+				Add("name offsets out of order", [&](auto& a_bytes) { Poke(a_bytes, nameOffsets + sizeof(std::uint32_t), std::uint32_t{ 0 }); });
+
+				auto overrideOffsets = offset + columnSize * 2 * sizeof(std::uint32_t);
+				Add("override offsets out of order", [&](auto& a_bytes) { Poke(a_bytes, overrideOffsets + sizeof(std::uint32_t), std::numeric_limits<std::uint32_t>::max()); });
+				break;
+			}
+		}
+
+		Add("override of a plugin that does not exist", [&](auto& a_bytes)
+			{
+				auto overrideCount = Peek<std::uint64_t>(a_bytes, offsetof(Header, overrideCount));
+				if (overrideCount > 0)
+				{
+					Poke(a_bytes, namesOffset - sizeof(std::uint32_t), pluginCount);
+				}
+			});
+
+		for (auto& fault : faults)
+		{
+			WriteFile(a_path, fault.bytes);
+			if (FormIndexCache::Load(a_path, FINGERPRINT))
+			{
+				std::printf("FAIL %s is accepted\n", fault.name);
+				failures++;
+			}
+		}
+
+		// Random damage anywhere in the file, which may well be harmless, must never be read outside of the mapping
+		std::mt19937 rng{ 11 };
+		std::size_t rejected{ 0 };
+		std::size_t checksum{ 0 };
+		for (std::size_t i = 0; i < a_flips; i++)
+		{
+			auto bytes = good;
+			for (auto count = 1 + rng() % 4; count > 0; count--)
+			{
+				bytes[rng() % bytes.size()] ^= static_cast<char>(1 + rng() % 255);
+			}
+
+			WriteFile(a_path, bytes);
+			if (auto index = FormIndexCache::Load(a_path, FINGERPRINT); index)
+			{
+				checksum += Walk(*index);
+			}
+			else
+			{
+				rejected++;
+			}
+		}
+
+		std::printf("corruption: %zu faults rejected, %zu of %zu random flips rejected, the rest read within bounds (checksum %zu)\n", faults.size(), rejected, a_flips, checksum);
+		WriteFile(a_path, good);
+	}
+
+	std::uint64_t GetFingerprint()
+	{
+		Menus::Utils::Fingerprint fingerprint;
+		fingerprint.Add(std::uint64_t{ FormIndex::VERSION });
+		auto sources = Menus::Utils::Fingerprint::Sources::Capture();
+		fingerprint.AddLoadOrder(sources);
+		fingerprint.AddStrings(sources);
+		return fingerprint.Get();
+	}
+
+	void Touch(const std::filesystem::path& a_path, std::string_view a_contents)
+	{
+		std::filesystem::create_directories(a_path.parent_path());
+		std::ofstream file{ a_path, std::ios::binary | std::ios::trunc };
+		file << a_contents;
+	}
+
+	// Runs in the scratch directory, which stands in for the game directory
+	void RunFingerprint()
+	{
+		RE::TESFile fallout4{ "Fallout4.esm", 0, 0, true };
+		RE::TESFile mod{ "Mod.esp", 1, 0, true };
+		RE::TESDataHandler::GetSingleton()->files = { &fallout4, &mod };
+
+		auto& settings = RE::INISettingCollection::GetSingleton()->settings;
+		settings["sLanguage:General"].value = "en";
+		settings["sResourceStartUpArchiveList:Archive"].value = "Fallout4 - Startup.ba2, Fallout4 - Interface.ba2";
+
+		Touch("Data/Fallout4.esm", "master"sv);
+		Touch("Data/Mod.esp", "plugin"sv);
+		Touch("Data/Fallout4 - Interface.ba2", "strings"sv);
+
+		auto base = GetFingerprint();
+		Expect(base == GetFingerprint(), "fingerprint is stable");
+
+		settings["sLanguage:General"].value = "de";
+		Expect(GetFingerprint() != base, "language change changes the fingerprint");
+		settings["sLanguage:General"].value = "en";
+		Expect(GetFingerprint() == base, "restoring the language restores the fingerprint");
+
+		Touch("Data/Strings/Mod_en.STRINGS", "loose"sv);
+		auto withLoose = GetFingerprint();
+		Expect(withLoose != base, "adding loose string tables changes the fingerprint");
+
+		Touch("Data/Strings/Mod_de.STRINGS", "other language"sv);
+		Expect(GetFingerprint() == withLoose, "string tables of another language do not change the fingerprint");
+
+		Touch("Data/Strings/Mod_en.DLSTRINGS", "loose"sv);
+		Expect(GetFingerprint() != withLoose, "adding loose DLSTRINGS changes the fingerprint");
+
+		auto beforeArchive = GetFingerprint();
+		Touch("Data/Mod - Main.ba2", "archive"sv);
+		Expect(GetFingerprint() != beforeArchive, "adding the plugin's archive changes the fingerprint");
+
+		auto beforeResize = GetFingerprint();
+		Touch("Data/Fallout4 - Interface.ba2", "replaced strings"sv);
+		Expect(GetFingerprint() != beforeResize, "replacing a startup archive changes the fingerprint");
+
+		auto beforeList = GetFingerprint();
+		settings["sResourceStartUpArchiveList:Archive"].value = "Fallout4 - Startup.ba2";
+		Expect(GetFingerprint() != beforeList, "archive list change changes the fingerprint");
+	}
+}
+
+int main(int a_argc, char** a_argv)
+{
+	auto forms = (a_argc > 1) ? std::strtoull(a_argv[1], nullptr, 10) : 20000;
+	auto flips = (a_argc > 2) ? std::strtoull(a_argv[2], nullptr, 10) : 2000;
+
+	auto scratch = std::filesystem::temp_directory_path() / fmt::format("form_index_cache_test.{}", ::getpid());
+	std::filesystem::create_directories(scratch);
+	std::filesystem::current_path(scratch);
+
+	std::vector<std::string> names;
+	auto index = Generate(forms, names);
+	auto path = scratch / "index.cache";
+	RunRoundTrip(index, path);
+	RunCorruption(path, flips);
+	RunFingerprint();
+
+	std::filesystem::current_path(std::filesystem::temp_directory_path());
+	std::filesystem::remove_all(scratch);
+
+	std::printf(failures ? "%d FAILED\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+// Test and benchmark for FormLabel against the fmt::format calls it replaced, run off the game machine.
+// Build with: g++ -std=c++20 -O2 -o form_label_test form_label_test.cpp -lfmt
+//
+// Usage:
+//   form_label_test [labels] [passes]    random FormIDs checked and timed after the plugin labels
+//
+// Every label has to match what the menu formatted before, "[{:08X}]" for forms, "[{:02X}]" for full plugins and
+// "[FE][{:03X}]" for light ones, for every full and light plugin index and for random FormIDs.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+using namespace std::literals;
+
+#include "../src/Menus/PluginExplorerMenu/FormLabel.h"
+
+namespace
+{
+	int failures{ 0 };
+
+	void RunPluginCases()
+	{
+		std::size_t mismatches{ 0 };
+		for (std::uint32_t compileIndex = 0; compileIndex < 0xFE; compileIndex++)
+		{
+			mismatches += Menus::FormLabel::Plugin(compileIndex, 0).view() != fmt::format(FMT_STRING("[{:02X}]"), compileIndex);
+		}
+
+		for (std::uint32_t lightIndex = 0; lightIndex < 0x1000; lightIndex++)
+		{
+			mismatches += Menus::FormLabel::Plugin(0xFE, lightIndex).view() != fmt::format(FMT_STRING("[FE][{:03X}]"), lightIndex);
+		}
+
+		std::printf("plugins: 254 full and 4096 light labels: %zu mismatches\n", mismatches);
+		if (mismatches != 0)
+		{
+			failures++;
+		}
+	}
+
+	template<class FUNC>
+	double Time(int a_passes, FUNC a_func)
+	{
+		double best{ 0.0 };
+		for (int pass = 0; pass < a_passes; pass++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			a_func();
+			auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			best = (pass == 0) ? seconds : std::min(best, seconds);
+		}
+
+		return best;
+	}
+
+	// One character of every label goes into a checksum, so neither path is optimized away
+	void RunFormCases(std::size_t a_labels, int a_passes)
+	{
+		std::mt19937 rng{ 11 };
+		std::vector<std::uint32_t> formIDs(a_labels);
+		for (auto& formID : formIDs)
+		{
+			formID = rng();
+		}
+
+		formIDs.insert(formIDs.end(), { 0x00000000, 0xFFFFFFFF, 0xFE000800, 0x0A0B0C0D });
+
+		std::size_t mismatches{ 0 };
+		for (auto formID : formIDs)
+		{
+			mismatches += Menus::FormLabel::FormID(formID).view() != fmt::format(FMT_STRING("[{:08X}]"), formID);
+		}
+
+		std::printf("forms: %zu random labels: %zu mismatches\n", formIDs.size(), mismatches);
+		if (mismatches != 0)
+		{
+			failures++;
+		}
+
+		std::size_t checksum{ 0 };
+		auto fmtSeconds = Time(
+			a_passes,
+			[&]()
+			{
+				for (auto formID : formIDs)
+				{
+					auto label = fmt::format(FMT_STRING("[{:08X}]"), formID);
+					checksum += static_cast<unsigned char>(label[4]);
+				}
+			});
+		auto labelSeconds = Time(
+			a_passes,
+			[&]()
+			{
+				for (auto formID : formIDs)
+				{
+					auto label = Menus::FormLabel::FormID(formID);
+					checksum += static_cast<unsigned char>(label.c_str()[4]);
+				}
+			});
+
+		std::printf(
+			"bench: fmt::format %.1fns, FormLabel %.1fns per label (checksum %zu)\n",
+			fmtSeconds * 1e9 / formIDs.size(),
+			labelSeconds * 1e9 / formIDs.size(),
+			checksum);
+	}
+}
+
+int main(int a_argc, char** a_argv)
+{
+	auto labels = (a_argc > 1) ? std::strtoull(a_argv[1], nullptr, 10) : 1000000;
+	auto passes = (a_argc > 2) ? std::max(std::atoi(a_argv[2]), 1) : 5;
+
+	RunPluginCases();
+	RunFormCases(labels, passes);
+
+	std::printf(failures ? "%d FAILED\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,260 @@
+// Differential test and benchmark for FormQuery's SSE2 and AVX2 paths, run off the game machine on x64.
+// Build with: g++ -std=c++20 -O2 -mavx2 -mxsave -I../src -o form_query_test form_query_test.cpp -lfmt
+//
+// Usage:
+//   form_query_test [queries] [forms] [passes]    random queries per list length, then a list to time the paths on
+//
+// Lists of every length up to 70 put forms on either side of each 4- and 8-wide block edge, so the scalar loop has
+// to pick up exactly where each vector loop stopped. Stats and bounds are drawn from a pool that mixes signed zeros,
+// infinities and NaN in with ordinary values: a NaN stat or a NaN bound must never match, and an infinite bound has to
+// leave that side of the range open. Every path has to return the same positions as a plain loop, in the same order.
+// The AVX2 path only runs where the processor has it.
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+using namespace std::literals;
+
+#include "re_stubs.h"
+
+#include "../src/Menus/PluginExplorerMenu/FormQuery.h"
+
+namespace
+{
+	using Menus::FormCategory;
+	using Menus::FormIndex;
+	using Menus::FormQuery;
+	using Menus::FormStat;
+	using Path = Menus::Utils::CpuFeatures::Path;
+
+	constexpr auto INF = std::numeric_limits<float>::infinity();
+	constexpr auto NaN = std::numeric_limits<float>::quiet_NaN();
+	constexpr std::array POOL{ -INF, -1000.0F, -1.5F, -0.0F, 0.0F, 0.5F, 1.0F, 10.0F, 250.0F, 1000.0F, INF, NaN };
+
+	int failures{ 0 };
+
+	std::vector<Path> GetPaths()
+	{
+		std::vector<Path> result{ Path::kScalar, Path::kSSE2 };
+		if (Menus::Utils::CpuFeatures::GetPath() == Path::kAVX2)
+		{
+			result.push_back(Path::kAVX2);
+		}
+
+		return result;
+	}
+
+	// Most stats come from the pool, the rest are spread between its values
+	float RandomValue(std::mt19937& a_rng)
+	{
+		if (a_rng() % 4 == 0)
+		{
+			return static_cast<float>(static_cast<std::int32_t>(a_rng() % 2001) - 1000) / 4.0F;
+		}
+
+		return POOL[a_rng() % POOL.size()];
+	}
+
+	FormIndex Generate(std::size_t a_forms, std::mt19937& a_rng)
+	{
+		FormIndex::Builder builder;
+		for (std::uint32_t i = 0; i < a_forms; i++)
+		{
+			Menus::FormStats stats{ RandomValue(a_rng), RandomValue(a_rng), RandomValue(a_rng) };
+			builder.Add(FormCategory{ 0 }, 0, i, "Form"sv, stats);
+		}
+
+		return builder.Build(1);
+	}
+
+	FormQuery RandomQuery(std::mt19937& a_rng)
+	{
+		FormQuery query;
+		for (auto count = 1 + a_rng() % 4; count > 0; count--)
+		{
+			auto lhs = RandomValue(a_rng);
+			auto rhs = RandomValue(a_rng);
+			if (!std::isnan(lhs) && !std::isnan(rhs) && lhs > rhs && a_rng() % 4 != 0)
+			{
+				std::swap(lhs, rhs);
+			}
+
+			query.Add(static_cast<FormStat>(a_rng() % FormIndex::STAT_COUNT), lhs, rhs);
+		}
+
+		return query;
+	}
+
+	// What every path has to agree with, one form and one predicate at a time
+	std::vector<std::uint32_t> RunReference(const FormIndex::FormList& a_forms, const FormQuery& a_query)
+	{
+		std::vector<std::uint32_t> result;
+		for (std::uint32_t pos = 0; pos < a_forms.size(); pos++)
+		{
+			bool matches{ true };
+			for (auto& predicate : a_query.GetPredicates())
+			{
+				auto value = a_forms.stat(predicate.stat, pos);
+				if (std::isnan(value) || std::isnan(predicate.min) || std::isnan(predicate.max) || value < predicate.min || value > predicate.max)
+				{
+					matches = false;
+				}
+			}
+
+			if (matches)
+			{
+				result.push_back(pos);
+			}
+		}
+
+		return result;
+	}
+
+	void RunLengths(std::size_t a_queries)
+	{
+		constexpr std::size_t MAX_LENGTH{ 70 };
+
+		std::mt19937 rng{ 17 };
+		std::size_t checks{ 0 };
+		std::size_t matches{ 0 };
+		std::size_t mismatches{ 0 };
+		for (std::size_t length = 0; length <= MAX_LENGTH; length++)
+		{
+			auto index = Generate(length, rng);
+			auto forms = index.GetForms(FormCategory{ 0 });
+			for (std::size_t i = 0; i < a_queries; i++)
+			{
+				auto query = RandomQuery(rng);
+				auto expected = RunReference(forms, query);
+				matches += expected.size();
+				for (auto path : GetPaths())
+				{
+					checks++;
+					if (query.Run(forms, path) != expected)
+					{
+						if (mismatches++ < 5)
+						{
+							std::printf(
+								"FAIL %s at length %zu: %zu predicates, %zu expected matches\n",
+								Menus::Utils::CpuFeatures::GetPathName(path).data(),
+								length,
+								query.GetPredicates().size(),
+								expected.size());
+						}
+					}
+				}
+			}
+		}
+
+		std::printf("lengths 0 to %zu: %zu runs, %zu matches expected, %zu mismatches\n", MAX_LENGTH, checks, matches, mismatches);
+		if (mismatches != 0)
+		{
+			failures++;
+		}
+	}
+
+	// Every NaN bound, and every stat stored as NaN, has to come back empty on each path
+	void RunNaN()
+	{
+		std::mt19937 rng{ 19 };
+		auto index = Generate(67, rng);
+		auto forms = index.GetForms(FormCategory{ 0 });
+
+		std::size_t matches{ 0 };
+		for (auto path : GetPaths())
+		{
+			for (auto [min, max] : { std::pair{ NaN, INF }, std::pair{ -INF, NaN }, std::pair{ NaN, NaN } })
+			{
+				FormQuery query;
+				query.Add(FormStat::kValue, min, max);
+				matches += query.Run(forms, path).size();
+			}
+
+			FormQuery open;
+			open.Add(FormStat::kWeight, -INF, INF);
+			for (auto pos : open.Run(forms, path))
+			{
+				matches += std::isnan(forms.stat(FormStat::kWeight, pos));
+			}
+		}
+
+		std::printf("NaN bounds and stats: %zu matches\n", matches);
+		if (matches != 0)
+		{
+			failures++;
+		}
+	}
+
+	template<class FUNC>
+	double Time(int a_passes, FUNC a_func)
+	{
+		double best{ 0.0 };
+		for (int pass = 0; pass < a_passes; pass++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			a_func();
+			auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			best = (pass == 0) ? seconds : std::min(best, seconds);
+		}
+
+		return best;
+	}
+
+	void Bench(std::size_t a_forms, int a_passes)
+	{
+		std::mt19937 rng{ 23 };
+		auto index = Generate(a_forms, rng);
+		auto forms = index.GetForms(FormCategory{ 0 });
+
+		FormQuery query;
+		query.Add(FormStat::kValue, 0.0F, 250.0F);
+		query.Add(FormStat::kWeight, -INF, 10.0F);
+		for (auto path : GetPaths())
+		{
+			std::size_t matches{ 0 };
+			auto seconds = Time(a_passes, [&]() { matches = query.Run(forms, path).size(); });
+			std::printf(
+				"  %-6s %8.2fms %8.2fns/form %zu matches\n",
+				Menus::Utils::CpuFeatures::GetPathName(path).data(),
+				seconds * 1e3,
+				seconds * 1e9 / a_forms,
+				matches);
+		}
+	}
+}
+
+int main(int a_argc, char** a_argv)
+{
+	auto queries = (a_argc > 1) ? std::strtoull(a_argv[1], nullptr, 10) : 2000;
+	auto forms = (a_argc > 2) ? std::strtoull(a_argv[2], nullptr, 10) : 1000000;
+	auto passes = (a_argc > 3) ? std::max(std::atoi(a_argv[3]), 1) : 5;
+
+	std::printf("detected path: %s\n", Menus::Utils::CpuFeatures::GetPathName(Menus::Utils::CpuFeatures::GetPath()).data());
+	RunLengths(queries);
+	RunNaN();
+	std::printf("bench: %zu forms, value in [0, 250] and weight <= 10\n", static_cast<std::size_t>(forms));
+	Bench(forms, passes);
+
+	std::printf(failures ? "%d FAILED\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,468 @@
+// Benchmark and check for FormSearch on a synthetic name corpus, run off the game machine on x64.
+// Build with: g++ -std=c++20 -O2 -mavx2 -mxsave -I../src -o form_search_bench form_search_bench.cpp -lfmt
+//
+// Usage:
+//   form_search_bench [names] [queries]    corpus size, and how many random queries are checked and timed
+//
+// Every search is compared against a brute-force scan that lowercases each name and looks for the query in it, ranked
+// by its own reading of the rules: exact, then prefix, then a match at a word start, then any other match, each class
+// by shorter name and then by entry. Queries under 3 characters go through the arena scan instead of the trigrams, and
+// queries typed one character at a time, or extended at the front, refine the previous results. The ranking is read
+// back in menu-sized pages so the partial sort is checked along with it. Latency covers a search and its first page.
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include <fmt/format.h>
+
+using namespace std::literals;
+
+#include "re_stubs.h"
+
+#include "../src/Menus/PluginExplorerMenu/FormSearch.h"
+
+namespace
+{
+	using Menus::FormCategory;
+	using Menus::FormIndex;
+	using Menus::FormSearch;
+
+	constexpr std::size_t PAGE_SIZE{ 100 };
+	constexpr std::array WORDS{
+		"Iron"sv, "Steel"sv, "Combat"sv, "Armor"sv, "Leather"sv, "Rifle"sv, "Pistol"sv, "Laser"sv, "Plasma"sv,
+		"Stimpak"sv, "RadAway"sv, "Nuka-Cola"sv, "Mutfruit"sv, "Fusion"sv, "Core"sv, "Power"sv, "Helmet"sv,
+		"Left"sv, "Right"sv, "Arm"sv, "Leg"sv, "Synth"sv, "Raider"sv, "Gunner"sv, "Vault-Tec"sv, "Holotape"sv,
+		"Note"sv, "Key"sv, "Terminal"sv, "Password"sv, "Mod"sv, "Receiver"sv, "Barrel"sv, "Scope"sv, "Sight"sv
+	};
+
+	int failures{ 0 };
+
+	char ToLower(char a_char)
+	{
+		return (a_char >= 'A' && a_char <= 'Z') ? static_cast<char>(a_char + ('a' - 'A')) : a_char;
+	}
+
+	std::string Lower(std::string_view a_string)
+	{
+		std::string result{ a_string };
+		std::transform(result.begin(), result.end(), result.begin(), ToLower);
+		return result;
+	}
+
+	// Common words so popular queries match tens of thousands of names, and made-up ones that only match a few
+	std::vector<std::string> GenerateNames(std::size_t a_count, std::mt19937& a_rng)
+	{
+		constexpr std::array SYLLABLES{ "ka"sv, "ro"sv, "vel"sv, "tin"sv, "mar"sv, "que"sv, "zo"sv, "lith"sv, "pra"sv, "dun"sv, "ex"sv, "wy"sv };
+		constexpr std::array SEPARATORS{ " "sv, " "sv, " "sv, "-"sv, " ("sv, ") "sv, "_"sv, "'s "sv };
+
+		std::vector<std::string> made;
+		for (std::size_t i = 0; i < 3000; i++)
+		{
+			std::string word;
+			for (auto count = 2 + a_rng() % 3; count > 0; count--)
+			{
+				word += SYLLABLES[a_rng() % SYLLABLES.size()];
+			}
+
+			word[0] = static_cast<char>(word[0] - ('a' - 'A'));
+			made.push_back(std::move(word));
+		}
+
+		std::vector<std::string> result;
+		result.reserve(a_count);
+		for (std::size_t i = 0; i < a_count; i++)
+		{
+			std::string name;
+			for (auto count = 1 + a_rng() % 4; count > 0; count--)
+			{
+				if (!name.empty())
+				{
+					name += SEPARATORS[a_rng() % SEPARATORS.size()];
+				}
+
+				switch (a_rng() % 8)
+				{
+				case 0:
+					name += std::to_string(a_rng() % 1000);
+					break;
+				case 1:
+				case 2:
+					name += made[a_rng() % made.size()];
+					break;
+				case 3:
+					name += Lower(WORDS[a_rng() % WORDS.size()]);
+					break;
+				default:
+					name += WORDS[a_rng() % WORDS.size()];
+					break;
+				}
+			}
+
+			result.push_back(std::move(name));
+		}
+
+		return result;
+	}
+
+	// Names are spread over every category and a handful of plugins, the way ingestion would leave them
+	FormIndex BuildIndex(const std::vector<std::string>& a_names)
+	{
+		constexpr std::uint32_t PLUGINS{ 8 };
+
+		FormIndex::Builder builder;
+		for (std::uint32_t i = 0; i < a_names.size(); i++)
+		{
+			builder.Add(FormCategory{ i % FormIndex::CATEGORY_COUNT }, (i / 7) % PLUGINS, i, a_names[i]);
+		}
+
+		return builder.Build(PLUGINS);
+	}
+
+	// Every name in entry order, numbered the way FormSearch numbers them
+	std::vector<std::string> GetLowerNames(const FormIndex& a_index)
+	{
+		std::vector<std::string> result;
+		for (std::uint32_t category = 0; category < FormIndex::CATEGORY_COUNT; category++)
+		{
+			for (auto entry : a_index.GetForms(static_cast<FormCategory>(category)))
+			{
+				result.push_back(Lower(entry.second));
+			}
+		}
+
+		return result;
+	}
+
+	std::vector<std::uint32_t> RankReference(const std::vector<std::string>& a_names, std::string_view a_query)
+	{
+		auto query = Lower(a_query);
+		std::vector<std::tuple<int, std::size_t, std::uint32_t>> keys;
+		for (std::uint32_t entry = 0; entry < a_names.size(); entry++)
+		{
+			std::string_view name{ a_names[entry] };
+			auto pos = name.find(query);
+			if (query.empty() || pos == std::string_view::npos)
+			{
+				continue;
+			}
+
+			int rating{ 3 };
+			if (pos == 0)
+			{
+				rating = (name.size() == query.size()) ? 0 : 1;
+			}
+			else
+			{
+				for (; pos != std::string_view::npos; pos = name.find(query, pos + 1))
+				{
+					auto before = static_cast<unsigned char>(name[pos - 1]);
+					if (before < 0x80 && !std::isalnum(before))
+					{
+						rating = 2;
+						break;
+					}
+				}
+			}
+
+			keys.emplace_back(rating, name.size(), entry);
+		}
+
+		std::sort(keys.begin(), keys.end());
+		std::vector<std::uint32_t> result;
+		result.reserve(keys.size());
+		for (auto& key : keys)
+		{
+			result.push_back(std::get<2>(key));
+		}
+
+		return result;
+	}
+
+	// Reads the first pages back one at a time, the way the menu pages through them, then the rest at once
+	std::vector<std::uint32_t> ReadRanking(FormSearch::Results& a_results)
+	{
+		constexpr std::size_t PAGES{ 3 };
+
+		std::vector<std::uint32_t> result;
+		for (std::size_t page = 0; page < PAGES; page++)
+		{
+			auto ranked = a_results.GetRanked(page * PAGE_SIZE, PAGE_SIZE);
+			result.insert(result.end(), ranked.begin(), ranked.end());
+		}
+
+		auto rest = a_results.GetRanked(PAGES * PAGE_SIZE, a_results.GetCount());
+		result.insert(result.end(), rest.begin(), rest.end());
+		return result;
+	}
+
+	struct Check
+	{
+		bool Run(const FormSearch& a_search, FormSearch::Results& a_results, std::string_view a_query)
+		{
+			checks++;
+			a_search.Search(a_query, a_results);
+			auto expected = RankReference(names, a_query);
+			matches += expected.size();
+			if (a_results.GetCount() == expected.size() && ReadRanking(a_results) == expected)
+			{
+				return true;
+			}
+
+			if (mismatches++ < 5)
+			{
+				std::printf("FAIL \"%.*s\": %zu matches, %zu expected\n", static_cast<int>(a_query.size()), a_query.data(), a_results.GetCount(), expected.size());
+			}
+
+			return false;
+		}
+
+		void Report(const char* a_label)
+		{
+			std::printf("%s: %zu searches, %zu matches expected, %zu mismatches\n", a_label, checks, matches, mismatches);
+			if (mismatches != 0)
+			{
+				failures++;
+			}
+		}
+
+		const std::vector<std::string>& names;
+		std::size_t checks{ 0 };
+		std::size_t matches{ 0 };
+		std::size_t mismatches{ 0 };
+	};
+
+	// One name for each way a query can rank, and for each tie-break between them
+	void RunRanking()
+	{
+		const std::vector<std::string> names{
+			"Environment",
+			"Rusty Iron Sword",
+			"Iron Sword",
+			"Ironclad",
+			"Iron",
+			"Steel-Iron",
+			"Environ Iron",
+			"iRON",
+			"\xC3\xA9iron",
+			"Irony(Iron)",
+			"Copper"
+		};
+		const std::vector<std::string_view> expected{
+			"Iron",
+			"iRON",
+			"Ironclad",
+			"Iron Sword",
+			"Irony(Iron)",
+			"Steel-Iron",
+			"Environ Iron",
+			"Rusty Iron Sword",
+			"\xC3\xA9iron",
+			"Environment"
+		};
+
+		FormIndex::Builder builder;
+		for (std::uint32_t i = 0; i < names.size(); i++)
+		{
+			builder.Add(FormCategory{ 0 }, 0, i, names[i]);
+		}
+
+		auto index = builder.Build(1);
+		FormSearch search{ std::addressof(index) };
+		std::size_t mismatches{ 0 };
+		for (auto query : { "iron"sv, "IRON"sv, "Iron"sv })
+		{
+			FormSearch::Results results;
+			search.Search(query, results);
+
+			std::vector<std::string_view> ranked;
+			for (auto entry : results.GetRanked(0, PAGE_SIZE))
+			{
+				ranked.push_back(search.GetName(entry));
+			}
+
+			if (ranked != expected)
+			{
+				mismatches++;
+				std::printf("FAIL ranking for \"%.*s\":", static_cast<int>(query.size()), query.data());
+				for (auto name : ranked)
+				{
+					std::printf(" \"%.*s\"", static_cast<int>(name.size()), name.data());
+				}
+
+				std::printf("\n");
+			}
+		}
+
+		std::printf("ranking: %zu mismatches\n", mismatches);
+		if (mismatches != 0)
+		{
+			failures++;
+		}
+	}
+
+	std::string RandomQuery(const std::vector<std::string>& a_names, std::size_t a_length, std::mt19937& a_rng)
+	{
+		std::string_view name{ a_names[a_rng() % a_names.size()] };
+		auto length = std::min(a_length, name.size());
+		auto query = std::string{ name.substr(a_rng() % (name.size() - length + 1), length) };
+		if (a_rng() % 2 == 0)
+		{
+			std::transform(query.begin(), query.end(), query.begin(), [](char a_char) { return static_cast<char>(std::toupper(static_cast<unsigned char>(a_char))); });
+		}
+
+		return query;
+	}
+
+	void RunChecks(const FormSearch& a_search, const std::vector<std::string>& a_corpus, const std::vector<std::string>& a_names, std::size_t a_queries)
+	{
+		std::mt19937 rng{ 29 };
+
+		Check shortQueries{ a_names };
+		for (std::size_t i = 0; i < std::max<std::size_t>(a_queries / 10, 8); i++)
+		{
+			FormSearch::Results results;
+			shortQueries.Run(a_search, results, RandomQuery(a_corpus, 1 + i % 2, rng));
+		}
+
+		shortQueries.Report("under 3 characters");
+
+		Check freshQueries{ a_names };
+		for (std::size_t i = 0; i < a_queries; i++)
+		{
+			FormSearch::Results results;
+			freshQueries.Run(a_search, results, RandomQuery(a_corpus, 3 + rng() % 10, rng));
+		}
+
+		for (auto query : { "qqq"sv, "zzzzzz"sv, "iron  steel"sv })
+		{
+			FormSearch::Results results;
+			freshQueries.Run(a_search, results, query);
+		}
+
+		freshQueries.Report("fresh queries");
+
+		// Typed forwards, then extended at the front, then edited into a query the results cannot be refined from
+		Check refinedQueries{ a_names };
+		for (std::size_t i = 0; i < a_queries / 4; i++)
+		{
+			auto target = RandomQuery(a_corpus, 4 + rng() % 10, rng);
+			std::string_view typed{ target };
+			auto start = rng() % typed.size();
+
+			FormSearch::Results results;
+			for (auto length = std::size_t{ 1 }; start + length <= typed.size(); length++)
+			{
+				refinedQueries.Run(a_search, results, typed.substr(start, length));
+			}
+
+			for (auto first = start; first-- > 0;)
+			{
+				refinedQueries.Run(a_search, results, typed.substr(first));
+			}
+
+			refinedQueries.Run(a_search, results, typed.substr(1));
+			refinedQueries.Run(a_search, results, ""sv);
+			refinedQueries.Run(a_search, results, typed.substr(0, 2));
+		}
+
+		refinedQueries.Report("refined queries");
+	}
+
+	struct Latency
+	{
+		void Add(double a_seconds) { samples.push_back(a_seconds); }
+
+		void Report(const char* a_label)
+		{
+			std::sort(samples.begin(), samples.end());
+			auto at = [&](double a_fraction) { return samples[static_cast<std::size_t>(a_fraction * (samples.size() - 1))] * 1e6; };
+			std::printf("  %-22s %6zu searches  p50 %9.1fus  p99 %9.1fus  max %9.1fus\n", a_label, samples.size(), at(0.5), at(0.99), samples.back() * 1e6);
+		}
+
+		std::vector<double> samples;
+	};
+
+	double TimeSearch(const FormSearch& a_search, FormSearch::Results& a_results, std::string_view a_query)
+	{
+		auto start = std::chrono::steady_clock::now();
+		a_search.Search(a_query, a_results);
+		[[maybe_unused]] auto page = a_results.GetRanked(0, PAGE_SIZE);
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void Bench(const FormSearch& a_search, const std::vector<std::string>& a_corpus, std::size_t a_queries)
+	{
+		std::mt19937 rng{ 31 };
+
+		Latency shortQueries;
+		Latency freshQueries;
+		Latency typedQueries;
+		for (std::size_t i = 0; i < a_queries; i++)
+		{
+			FormSearch::Results shortResults;
+			shortQueries.Add(TimeSearch(a_search, shortResults, RandomQuery(a_corpus, 1 + i % 2, rng)));
+
+			FormSearch::Results freshResults;
+			freshQueries.Add(TimeSearch(a_search, freshResults, RandomQuery(a_corpus, 3 + rng() % 10, rng)));
+
+			auto target = RandomQuery(a_corpus, 4 + rng() % 10, rng);
+			FormSearch::Results typedResults;
+			for (std::size_t length = 1; length <= target.size(); length++)
+			{
+				typedQueries.Add(TimeSearch(a_search, typedResults, std::string_view{ target }.substr(0, length)));
+			}
+		}
+
+		shortQueries.Report("under 3 characters");
+		freshQueries.Report("fresh queries");
+		typedQueries.Report("typed, per keystroke");
+	}
+}
+
+int main(int a_argc, char** a_argv)
+{
+	auto count = (a_argc > 1) ? std::max<std::size_t>(std::strtoull(a_argv[1], nullptr, 10), 1) : 500000;
+	auto queries = (a_argc > 2) ? std::strtoull(a_argv[2], nullptr, 10) : 200;
+
+	RunRanking();
+
+	std::mt19937 rng{ 37 };
+	auto corpus = GenerateNames(count, rng);
+
+	auto start = std::chrono::steady_clock::now();
+	auto index = BuildIndex(corpus);
+	FormSearch search{ std::addressof(index) };
+	auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf(
+		"%zu names, %zu trigrams, %.1f MiB of postings, built in %.0fms\n",
+		corpus.size(),
+		search.GetTrigramCount(),
+		search.GetByteSize() / 1048576.0,
+		seconds * 1e3);
+
+	RunChecks(search, corpus, GetLowerNames(index), queries);
+	std::printf("latency, search and first page of %zu:\n", PAGE_SIZE);
+	Bench(search, corpus, queries);
+
+	std::printf(failures ? "%d FAILED\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,309 @@
+// Test and benchmark for NameScanner's scalar, SSE2 and AVX2 paths, run off the game machine on x64.
+// Build with: g++ -std=c++20 -O2 -mavx2 -mxsave -I../src -o name_scanner_test name_scanner_test.cpp
+//
+// Usage:
+//   name_scanner_test [names] [passes]    synthetic arena to time the paths on, after the checks
+//
+// Every path is checked against a byte-by-byte search over arenas whose lengths put matches on either side of each
+// block edge, and over UTF-8 names, where a valid needle must only ever match on a character boundary and bytes from
+// 0x80 up must never be case folded. The AVX2 path only runs where the processor has it.
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+
+#include "../src/Menus/PluginExplorerMenu/NameScanner.h"
+
+namespace
+{
+	using Path = Menus::Utils::CpuFeatures::Path;
+
+	int failures{ 0 };
+
+	std::vector<Path> GetPaths()
+	{
+		std::vector<Path> result{ Path::kScalar, Path::kSSE2 };
+		if (Menus::Utils::CpuFeatures::GetPath() == Path::kAVX2)
+		{
+			result.push_back(Path::kAVX2);
+		}
+
+		return result;
+	}
+
+	char ToLower(char a_char)
+	{
+		return (a_char >= 'A' && a_char <= 'Z') ? static_cast<char>(a_char + ('a' - 'A')) : a_char;
+	}
+
+	// Every match, overlapping ones included
+	std::vector<std::size_t> FindAll(std::string_view a_arena, std::string_view a_needle)
+	{
+		std::vector<std::size_t> result;
+		for (std::size_t pos = 0; pos + a_needle.size() <= a_arena.size() && !a_needle.empty(); pos++)
+		{
+			std::size_t i = 0;
+			while (i < a_needle.size() && ToLower(a_arena[pos + i]) == a_needle[i])
+			{
+				i++;
+			}
+
+			if (i == a_needle.size())
+			{
+				result.push_back(pos);
+			}
+		}
+
+		return result;
+	}
+
+	std::vector<std::size_t> Scan(std::string_view a_arena, std::string_view a_needle, Path a_path)
+	{
+		std::vector<std::size_t> result;
+		Menus::NameScanner::Scan(
+			a_arena,
+			a_needle,
+			[&](std::size_t a_offset)
+			{
+				result.push_back(a_offset);
+				return a_offset + 1;
+			},
+			a_path);
+		return result;
+	}
+
+	// Resumes after the NUL that ends the matching name, the way FormSearch takes one match per name
+	std::vector<std::size_t> ScanNames(std::string_view a_arena, std::string_view a_needle, Path a_path)
+	{
+		std::vector<std::size_t> result;
+		Menus::NameScanner::Scan(
+			a_arena,
+			a_needle,
+			[&](std::size_t a_offset)
+			{
+				result.push_back(a_offset);
+				auto end = a_arena.find('\0', a_offset);
+				return (end != std::string_view::npos) ? end + 1 : a_arena.size();
+			},
+			a_path);
+		return result;
+	}
+
+	std::vector<std::size_t> FindNames(std::string_view a_arena, std::string_view a_needle)
+	{
+		std::vector<std::size_t> result;
+		std::size_t nameEnd{ 0 };
+		for (auto pos : FindAll(a_arena, a_needle))
+		{
+			if (result.empty() || pos >= nameEnd)
+			{
+				result.push_back(pos);
+				auto end = a_arena.find('\0', pos);
+				nameEnd = (end != std::string_view::npos) ? end + 1 : a_arena.size();
+			}
+		}
+
+		return result;
+	}
+
+	void Expect(const char* a_name, std::string_view a_arena, std::string_view a_needle, const std::vector<std::size_t>& a_expected)
+	{
+		for (auto path : GetPaths())
+		{
+			if (auto actual = Scan(a_arena, a_needle, path); actual != a_expected)
+			{
+				std::printf("FAIL %s (%s): %zu matches, expected %zu\n", a_name, Menus::Utils::CpuFeatures::GetPathName(path).data(), actual.size(), a_expected.size());
+				failures++;
+			}
+		}
+	}
+
+	void RunUTF8Cases()
+	{
+		// "Über Café" and "ÜBER CAFÉ": Ü is C3 9C, É is C3 89, é is C3 A9
+		// The literals are split where a hex escape would otherwise run into the letters after it
+		constexpr auto arena = "\xC3\x9C" "ber Caf\xC3\xA9\0\xC3\x9C" "BER CAF\xC3\x89"sv;
+
+		Expect("ASCII folds next to UTF-8", arena, "ber"sv, { 2, 14 });
+		Expect("UTF-8 needle matches its own case", arena, "caf\xC3\xA9"sv, { 6 });
+		Expect("UTF-8 is not case folded", "CAF\xC3\x89"sv, "caf\xC3\xA9"sv, {});
+		Expect("lead byte alone is a boundary match", arena, "\xC3"sv, { 0, 9, 12, 21 });
+
+		// 0xC1-0xDA sit 0x80 above A-Z, so a fold that ignored the high bit would turn Á (C3 81) into á (C3 A1)
+		std::string upper;
+		for (int i = 0; i < 40; i++)
+		{
+			upper += "\xC3\x81"sv;
+		}
+
+		Expect("bytes above 0x80 are not folded", upper, "\xC3\xA1"sv, {});
+		Expect("bytes above 0x80 match as-is", upper, "\xC3\x81\xC3\x81"sv, FindAll(upper, "\xC3\x81\xC3\x81"sv));
+
+		// Random names of two and three byte characters: any valid needle only matches where a character starts
+		const std::string_view characters[]{ "a"sv, "B"sv, " "sv, "\xC3\xA9"sv, "\xC3\x89"sv, "\xC3\xBC"sv, "\xE2\x82\xAC"sv, "\xE6\x97\xA5"sv, "\xC2\xA9"sv };
+		std::mt19937 rng{ 3 };
+		std::size_t mismatches{ 0 };
+		std::size_t offBoundary{ 0 };
+		for (int round = 0; round < 2000; round++)
+		{
+			std::string names;
+			for (auto count = rng() % 12; count > 0; count--)
+			{
+				for (auto length = 1 + rng() % 8; length > 0; length--)
+				{
+					names += characters[rng() % std::size(characters)];
+				}
+
+				names += '\0';
+			}
+
+			std::string needle;
+			for (auto length = 1 + rng() % 3; length > 0; length--)
+			{
+				auto character = characters[rng() % std::size(characters)];
+				needle += (character == "B"sv) ? "b"sv : character;
+			}
+
+			auto expected = FindAll(names, needle);
+			for (auto pos : expected)
+			{
+				offBoundary += (static_cast<std::uint8_t>(names[pos]) & 0xC0) == 0x80;
+			}
+
+			for (auto path : GetPaths())
+			{
+				mismatches += Scan(names, needle, path) != expected;
+			}
+		}
+
+		std::printf("utf-8: 2000 random arenas: %zu mismatches, %zu matches off a character boundary\n", mismatches, offBoundary);
+		if (mismatches != 0 || offBoundary != 0)
+		{
+			failures++;
+		}
+	}
+
+	// Arenas of every length up to a few blocks, with the needle at every position, so matches land on both sides of
+	// each block edge and in the tail the scalar loop finishes
+	void RunEdgeCases()
+	{
+		std::size_t mismatches{ 0 };
+		for (std::size_t length = 0; length < 100; length++)
+		{
+			for (auto needle : { "x"sv, "xy"sv, "xyz"sv, "xyzxyzxyzxyzxyzxyzxyz"sv })
+			{
+				for (std::size_t at = 0; at + needle.size() <= length; at++)
+				{
+					std::string arena(length, 'a');
+					for (std::size_t i = 0; i < needle.size(); i++)
+					{
+						arena[at + i] = (i % 2) ? needle[i] : static_cast<char>(needle[i] - ('a' - 'A'));
+					}
+
+					if (at % 7 == 0 && at > 0)
+					{
+						arena[at - 1] = '\0';
+					}
+
+					auto expected = FindAll(arena, needle);
+					auto expectedNames = FindNames(arena, needle);
+					for (auto path : GetPaths())
+					{
+						mismatches += Scan(arena, needle, path) != expected;
+						mismatches += ScanNames(arena, needle, path) != expectedNames;
+					}
+				}
+			}
+		}
+
+		// Overlapping matches across a whole block
+		std::string repeated(70, 'A');
+		for (auto path : GetPaths())
+		{
+			mismatches += Scan(repeated, "aa"sv, path) != FindAll(repeated, "aa"sv);
+			mismatches += ScanNames(repeated, "aa"sv, path) != std::vector<std::size_t>{ 0 };
+		}
+
+		std::printf("edges: lengths 0-99, needles of 1-21 bytes at every position: %zu mismatches\n", mismatches);
+		if (mismatches != 0)
+		{
+			failures++;
+		}
+	}
+
+	template<class FUNC>
+	double Time(int a_passes, FUNC a_func)
+	{
+		double best{ 0.0 };
+		for (int pass = 0; pass < a_passes; pass++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			a_func();
+			auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			best = (pass == 0) ? seconds : std::min(best, seconds);
+		}
+
+		return best;
+	}
+
+	void Bench(std::size_t a_names, int a_passes)
+	{
+		const std::string_view words[]{ "Iron"sv, "Sword"sv, "of"sv, "the"sv, "Raider"sv, "Armor"sv, "Leather"sv, "Pipe"sv, "Nuka"sv, "Cola"sv, "\xC3\x9C" "ber"sv };
+		std::mt19937 rng{ 5 };
+		std::string arena;
+		for (std::size_t i = 0; i < a_names; i++)
+		{
+			for (auto count = 1 + rng() % 4; count > 0; count--)
+			{
+				arena += words[rng() % std::size(words)];
+				arena += ' ';
+			}
+
+			arena.back() = '\0';
+		}
+
+		std::printf("bench: %zu names, %.1fMB\n", a_names, arena.size() / 1e6);
+		for (auto needle : { "q"sv, "zx"sv, "ka"sv })
+		{
+			for (auto path : GetPaths())
+			{
+				std::size_t count{ 0 };
+				auto seconds = Time(a_passes, [&]() { count = ScanNames(arena, needle, path).size(); });
+				std::printf(
+					"  \"%s\" %-6s %8.2fms %7.0fMB/s %zu names\n",
+					needle.data(),
+					Menus::Utils::CpuFeatures::GetPathName(path).data(),
+					seconds * 1e3,
+					arena.size() / seconds / 1e6,
+					count);
+			}
+		}
+	}
+}
+
+int main(int a_argc, char** a_argv)
+{
+	auto names = (a_argc > 1) ? std::strtoull(a_argv[1], nullptr, 10) : 500000;
+	auto passes = (a_argc > 2) ? std::max(std::atoi(a_argv[2]), 1) : 5;
+
+	std::printf("detected path: %s\n", Menus::Utils::CpuFeatures::GetPathName(Menus::Utils::CpuFeatures::GetPath()).data());
+	RunUTF8Cases();
+	RunEdgeCases();
+	Bench(names, passes);
+
+	std::printf(failures ? "%d FAILED\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
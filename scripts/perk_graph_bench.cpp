@@ -0,0 +1,252 @@
+// Benchmark and check for PerkGraph on synthetic perk data, run off the game machine.
+// Build with: g++ -std=c++20 -O2 -o perk_graph_bench perk_graph_bench.cpp
+//
+// Usage:
+//   perk_graph_bench [chains] [ranks] [passes]    chains of up to the given number of ranks each
+//
+// Well-formed graphs are resolved both by PerkGraph and by the per-perk walk PerkManager used before it, and the
+// chains are compared. Malformed graphs, with links into the middle of chains, are only resolved by PerkGraph,
+// the old walk does not terminate on them.
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <random>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#define FMT_STRING(a_format) a_format
+
+namespace logger
+{
+	template<class... ARGS>
+	void debug(ARGS&&...)
+	{}
+}
+
+namespace RE
+{
+	struct BGSPerk
+	{
+		struct Data
+		{
+			std::int8_t level;
+			std::int8_t numRanks;
+		};
+
+		std::uint32_t formID;
+		Data data;
+		BGSPerk* nextPerk{ nullptr };
+	};
+}
+
+#include "../src/Menus/LevelUpMenu/PerkGraph.h"
+
+namespace
+{
+	struct Graph
+	{
+		std::vector<std::unique_ptr<RE::BGSPerk>> storage;
+		std::vector<RE::BGSPerk*> perks;
+		std::size_t rankCount{ 0 };
+	};
+
+	// Chains get consecutive formIDs in rank order and rising levels, so both resolvers agree on where they start.
+	// Half of the multi-rank chains link their last rank back to their first.
+	Graph Generate(std::size_t a_chains, std::size_t a_ranks, bool a_isMalformed, std::uint32_t a_seed)
+	{
+		std::mt19937 rng{ a_seed };
+		Graph result;
+		std::uint32_t formID{ 0x800 };
+		std::vector<RE::BGSPerk*> chain;
+		for (std::size_t i = 0; i < a_chains; i++)
+		{
+			chain.clear();
+			auto length = 1 + rng() % a_ranks;
+			for (std::size_t rank = 0; rank < length; rank++)
+			{
+				auto level = static_cast<std::int8_t>(std::min<std::size_t>(1 + rank * 100 / a_ranks, 120));
+				auto& perk = result.storage.emplace_back(new RE::BGSPerk{ formID++, { level, static_cast<std::int8_t>(std::min<std::size_t>(length, 127)) } });
+				chain.push_back(perk.get());
+			}
+
+			for (std::size_t rank = 0; rank + 1 < chain.size(); rank++)
+			{
+				chain[rank]->nextPerk = chain[rank + 1];
+			}
+
+			if (chain.size() > 1 && rng() % 2)
+			{
+				chain.back()->nextPerk = a_isMalformed ? chain[1 + rng() % (chain.size() - 1)] : chain.front();
+			}
+			else if (a_isMalformed && !result.perks.empty() && rng() % 4 == 0)
+			{
+				chain.back()->nextPerk = result.perks[rng() % result.perks.size()];
+			}
+
+			result.perks.insert(result.perks.end(), chain.begin(), chain.end());
+			result.rankCount += chain.size();
+		}
+
+		std::ranges::shuffle(result.perks, rng);
+		return result;
+	}
+
+	using Chains = std::vector<std::vector<RE::BGSPerk*>>;
+
+	// What PerkManager did before PerkGraph: every listed perk walks forward to find where its chain starts,
+	// then the chain is walked again to build it, and cycles are only caught when they return to the first rank
+	Chains ResolveLegacy(const Graph& a_graph)
+	{
+		std::map<std::uint32_t, RE::BGSPerk*> perkMap;
+		for (auto perk : a_graph.perks)
+		{
+			perkMap.insert_or_assign(perk->formID, perk);
+		}
+
+		Chains result;
+		for (auto& [formID, perk] : perkMap)
+		{
+			if (!perk)
+			{
+				continue;
+			}
+
+			auto basePerk = perk;
+			auto nextPerk = perk->nextPerk;
+			for (auto i = 0; nextPerk && i < perk->data.numRanks; i++)
+			{
+				if (basePerk->data.level > nextPerk->data.level)
+				{
+					basePerk = nextPerk;
+				}
+
+				nextPerk = nextPerk->nextPerk;
+			}
+
+			auto& chain = result.emplace_back();
+			if (!basePerk->nextPerk && basePerk->data.numRanks > 1)
+			{
+				chain.assign(basePerk->data.numRanks, basePerk);
+			}
+			else
+			{
+				auto rank = basePerk;
+				do
+				{
+					chain.push_back(rank);
+					rank = rank->nextPerk;
+				}
+				while (rank && rank != chain[0]);
+			}
+
+			for (auto rank : chain)
+			{
+				perkMap.insert_or_assign(rank->formID, nullptr);
+			}
+		}
+
+		return result;
+	}
+
+	Chains Resolve(const Graph& a_graph, std::size_t& a_malformedCount)
+	{
+		Menus::PerkGraph graph;
+		graph.Build(a_graph.perks);
+		a_malformedCount = graph.GetMalformedCount();
+
+		Chains result;
+		for (std::size_t i = 0; i < graph.size(); i++)
+		{
+			auto ranks = graph[i];
+			result.emplace_back(ranks.begin(), ranks.end());
+		}
+
+		return result;
+	}
+
+	// Every generated perk has to be in exactly one chain, each only once, except for multi-rank perks on their own
+	bool IsPartition(const Graph& a_graph, const Chains& a_chains)
+	{
+		std::map<RE::BGSPerk*, std::size_t> seen;
+		for (std::size_t i = 0; i < a_chains.size(); i++)
+		{
+			for (auto perk : a_chains[i])
+			{
+				if (auto [iter, inserted] = seen.try_emplace(perk, i); !inserted && (iter->second != i || a_chains[i].size() == 1))
+				{
+					return false;
+				}
+			}
+		}
+
+		return seen.size() == a_graph.perks.size();
+	}
+
+	template<class FUNC>
+	double Time(int a_passes, FUNC a_func)
+	{
+		double best{ 0.0 };
+		for (int pass = 0; pass < a_passes; pass++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			a_func();
+			auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			best = (pass == 0) ? seconds : std::min(best, seconds);
+		}
+
+		return best;
+	}
+
+	int Bench(std::size_t a_chains, std::size_t a_ranks, int a_passes)
+	{
+		auto graph = Generate(a_chains, a_ranks, false, 1);
+		std::size_t malformedCount{ 0 };
+		Chains chains, legacyChains;
+		auto seconds = Time(a_passes, [&]() { chains = Resolve(graph, malformedCount); });
+		auto legacySeconds = Time(a_passes, [&]() { legacyChains = ResolveLegacy(graph); });
+
+		auto isMatch = (chains == legacyChains && malformedCount == 0);
+		std::printf(
+			"well-formed: %zu chains, %zu ranks: %.2fms, legacy %.2fms, %s\n",
+			chains.size(),
+			graph.rankCount,
+			seconds * 1e3,
+			legacySeconds * 1e3,
+			isMatch ? "chains match" : "CHAINS DIFFER");
+
+		auto malformed = Generate(a_chains, a_ranks, true, 2);
+		seconds = Time(a_passes, [&]() { chains = Resolve(malformed, malformedCount); });
+
+		auto isPartition = IsPartition(malformed, chains);
+		std::printf(
+			"malformed: %zu chains, %zu ranks, %zu malformed links: %.2fms, %s\n",
+			chains.size(),
+			malformed.rankCount,
+			malformedCount,
+			seconds * 1e3,
+			isPartition ? "every rank in one chain" : "RANKS LOST OR REPEATED");
+
+		return (isMatch && isPartition) ? 0 : 1;
+	}
+}
+
+int main(int a_argc, char** a_argv)
+{
+	auto chains = (a_argc > 1) ? std::strtoull(a_argv[1], nullptr, 10) : 3000;
+	auto ranks = (a_argc > 2) ? std::strtoull(a_argv[2], nullptr, 10) : 5;
+	auto passes = (a_argc > 3) ? std::max(std::atoi(a_argv[3]), 1) : 5;
+	if (chains == 0 || ranks == 0)
+	{
+		std::fprintf(stderr, "usage: %s [chains] [ranks] [passes]\n", a_argv[0]);
+		return 1;
+	}
+
+	return Bench(chains, ranks, passes);
+}
@@ -0,0 +1,1016 @@
+// Headless test and benchmark for the PluginExplorer index build, run off the game machine on a synthetic load order.
+// Build with: g++ -std=c++20 -O2 -mavx2 -mxsave -I../src -o plugin_explorer_test plugin_explorer_test.cpp -lboost_iostreams -lfmt
+//
+// Usage:
+//   plugin_explorer_test [forms] [plugins] [passes]    synthetic load order to build from, spread over every category
+//
+// A load order of 254 full and 4000 light plugins has to give every plugin its own key, slot and label, with every form
+// in the plugin its FormID names. PluginExplorer::Initialize is then run with one worker thread and then with several,
+// and the index images have to be identical byte for byte, also when the game's form arrays are reallocated while the
+// build runs. The stubbed game data covers what ingestion filters on: forms from inactive or missing files, unnamed
+// forms, unplayable ones in the categories that filter on it, light plugins, overrides from later files, and leveled
+// lists named by editor ID or, where that was stripped, by plugin and FormID label. The game's virtuals may only be
+// called on the thread that ran Initialize. Walking a complete snapshot the way the menu does, every plugin, category,
+// form, name, stat, override and label, must not allocate at all. A build that is reset or throws has to leave the
+// explorer in a state that says so. Stale index caches have to be removed and the new one mapped back under its
+// fingerprint.
+//
+// The benchmark times Initialize until the snapshot is complete, and on its own for what the game's thread waits, and
+// reports the index size per form, next to the std::map per category and plugin that Initialize filled before the
+// columnar index. Sizes count the bytes requested from operator new, so allocator overhead is left out of both.
+// Ingestion is also timed per form type, from the build's own log on one thread and from the std::map path with its
+// tree lookup of each form's plugin. Last, the same forms are built with later plugins overriding more and more of
+// them, and every override list is checked against the load order.
+
+#include <cpuid.h>
+#include <immintrin.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <fmt/format.h>
+
+using namespace std::literals;
+
+namespace
+{
+	std::atomic<std::size_t> allocatedBytes{ 0 };
+	std::atomic<std::size_t> allocationCount{ 0 };
+}
+
+// Counts what the index requests. Every unaligned form is replaced, so nothing allocated here reaches the library's own
+// delete or the reverse, and they are kept out of line, or GCC inlines them and warns that free is handed what
+// operator new returned.
+[[gnu::noinline]] void* operator new(std::size_t a_size)
+{
+	allocatedBytes += a_size;
+	allocationCount++;
+	if (auto result = std::malloc(a_size ? a_size : 1); result)
+	{
+		return result;
+	}
+
+	throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void* operator new(std::size_t a_size, const std::nothrow_t&) noexcept
+{
+	allocatedBytes += a_size;
+	allocationCount++;
+	return std::malloc(a_size ? a_size : 1);
+}
+
+[[gnu::noinline]] void* operator new[](std::size_t a_size)
+{
+	return operator new(a_size);
+}
+
+[[gnu::noinline]] void* operator new[](std::size_t a_size, const std::nothrow_t& a_tag) noexcept
+{
+	return operator new(a_size, a_tag);
+}
+
+[[gnu::noinline]] void operator delete(void* a_ptr) noexcept
+{
+	std::free(a_ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* a_ptr, std::size_t) noexcept
+{
+	std::free(a_ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* a_ptr, const std::nothrow_t&) noexcept
+{
+	std::free(a_ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* a_ptr) noexcept
+{
+	std::free(a_ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* a_ptr, std::size_t) noexcept
+{
+	std::free(a_ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* a_ptr, const std::nothrow_t&) noexcept
+{
+	std::free(a_ptr);
+}
+
+#include "re_stubs.h"
+
+#include "../src/Menus/PluginExplorerMenu/FormLabel.h"
+#include "../src/Menus/PluginExplorerMenu/FormQuery.h"
+#include "../src/Menus/PluginExplorerMenu/PluginExplorer.h"
+
+namespace
+{
+	using Menus::PluginExplorer;
+
+	// AddItems hands inventory types straight to AddObjectToContainer, which would add a leveled list unresolved
+	static_assert(Menus::FormRegistry::IsInventoryType(RE::ENUM_FORM_ID::kWEAP));
+	static_assert(!Menus::FormRegistry::IsInventoryType(RE::ENUM_FORM_ID::kLVLI));
+
+	constexpr std::string_view WORDS[]{
+		"Iron"sv, "Sword"sv, "of"sv, "the"sv, "Raider"sv, "Armor"sv, "Leather"sv, "Pipe"sv, "Pistol"sv, "Rifle"sv,
+		"Nuka"sv, "Cola"sv, "Quantum"sv, "Stimpak"sv, "Combat"sv, "Knife"sv, "Laser"sv, "Plasma"sv, "Mutfruit"sv, "Tato"sv,
+		"Holotape"sv, "Key"sv, "Note"sv, "Vault"sv, "Brotherhood"sv, "Minutemen"sv, "Institute"sv, "Railroad"sv, "Power"sv, "Mod"sv
+	};
+
+	// Categories marked SKIP_PLAYABLE list their unplayable forms too
+	template<class T>
+	bool ChecksPlayable()
+	{
+		bool result{ true };
+		Menus::FormRegistry::ForEach(
+			[&]<class CATEGORY>()
+			{
+				if constexpr (std::is_same_v<typename CATEGORY::form_type, T>)
+				{
+					result = !requires { CATEGORY::SKIP_PLAYABLE; };
+				}
+			});
+
+		return result;
+	}
+
+	// Owns the synthetic game data the stubbed TESDataHandler hands out, and takes it back out when destroyed
+	class LoadOrder
+	{
+	public:
+		// Light plugins are mixed in at random, unless a_fullPlugins is set: then that many full plugins come first and
+		// every plugin after them is light, all of them active. Each later plugin overrides a form one time in
+		// a_overrideOdds, or never at 0.
+		LoadOrder(std::size_t a_forms, std::size_t a_plugins, std::size_t a_fullPlugins = 0, std::uint32_t a_overrideOdds = 64) :
+			overrideOdds(a_overrideOdds)
+		{
+			std::mt19937 rng{ 13 };
+			for (std::size_t i = 0; i < a_plugins; i++)
+			{
+				// Files that are not active keep the game's 0xFF compile index
+				auto light = a_fullPlugins ? (i >= a_fullPlugins) : (i > 0 && rng() % 3 == 0);
+				auto active = a_fullPlugins || rng() % 10 != 0;
+				auto& file = files.emplace_back(new RE::TESFile{
+					fmt::format("Plugin{:03d}.{:s}", i, light ? "esl" : "esp"),
+					static_cast<std::uint8_t>(!active ? 0xFF : light ? 0xFE : fullCount),
+					static_cast<std::uint16_t>((active && light) ? lightCount : 0),
+					active });
+				if (active)
+				{
+					light ? lightCount++ : fullCount++;
+				}
+
+				RE::TESDataHandler::GetSingleton()->files.push_back(file.get());
+			}
+
+			// Every category gets its share, stored through the same per-type arrays the game keeps
+			nextFormIDs.resize(files.size());
+			Add<RE::AlchemyItem>(a_forms, rng);
+			Add<RE::TESAmmo>(a_forms, rng);
+			Add<RE::TESObjectARMO>(a_forms, rng);
+			Add<RE::TESObjectBOOK>(a_forms, rng);
+			Add<RE::TESFlora>(a_forms, rng);
+			Add<RE::BGSNote>(a_forms, rng);
+			Add<RE::IngredientItem>(a_forms, rng);
+			Add<RE::TESKey>(a_forms, rng);
+			Add<RE::TESLevItem>(a_forms, rng);
+			Add<RE::TESObjectMISC>(a_forms, rng);
+			Add<RE::TESNPC>(a_forms, rng);
+			Add<RE::BGSMod::Attachment::Mod>(a_forms, rng);
+			Add<RE::TESObjectWEAP>(a_forms, rng);
+		}
+
+		LoadOrder(const LoadOrder&) = delete;
+		LoadOrder& operator=(const LoadOrder&) = delete;
+
+		~LoadOrder()
+		{
+			RE::TESDataHandler::GetSingleton()->files.clear();
+			for (auto& clear : clears)
+			{
+				clear();
+			}
+		}
+
+		[[nodiscard]] std::size_t GetFormCount() const noexcept { return formCount; }
+		[[nodiscard]] std::size_t GetIndexedCount() const noexcept { return indexedCount; }
+		[[nodiscard]] std::span<const std::unique_ptr<RE::TESFile>> GetFiles() const noexcept { return files; }
+
+		[[nodiscard]] const RE::TESForm* Find(std::uint32_t a_formID) const
+		{
+			auto iter = forms.find(a_formID);
+			return (iter != forms.end()) ? iter->second : nullptr;
+		}
+
+	private:
+		template<class T>
+		void Add(std::size_t a_forms, std::mt19937& a_rng)
+		{
+			static std::vector<std::unique_ptr<T>> storage;
+			auto& array = RE::TESDataHandler::GetSingleton()->GetFormArray<T>();
+			clears.push_back(
+				[&array]()
+				{
+					array.clear();
+					storage.clear();
+				});
+
+			for (std::size_t i = 0; i < a_forms / 13; i++)
+			{
+				// FormIDs carry their plugin's index the way the game assigns them
+				auto form = std::make_unique<T>();
+				auto origin = a_rng() % files.size();
+				auto& file = *files[origin];
+				auto id = nextFormIDs[origin]++;
+				if (file.compileIndex == 0xFE)
+				{
+					form->formID = (0xFEu << 24) | (static_cast<std::uint32_t>(file.smallFileCompileIndex) << 12) | (id & 0xFFF);
+				}
+				else
+				{
+					form->formID = (static_cast<std::uint32_t>(file.compileIndex) << 24) | (id & 0xFFFFFF);
+				}
+
+				form->playable = (a_rng() % 20 != 0);
+				if (a_rng() % 10 != 0)
+				{
+					for (auto count = 1 + a_rng() % 4; count > 0; count--)
+					{
+						form->fullName += WORDS[a_rng() % std::size(WORDS)];
+						form->fullName += ' ';
+					}
+
+					form->fullName += std::to_string(a_rng() % 1000);
+				}
+
+				// The game strips most editor IDs at runtime, and leveled lists have no full name
+				if constexpr (std::is_same_v<T, RE::TESLevItem>)
+				{
+					form->fullName.clear();
+					if (a_rng() % 4 == 0)
+					{
+						form->editorID = fmt::format("LL_{:d}", a_rng() % 100000);
+					}
+				}
+
+				if constexpr (std::is_base_of_v<RE::TESValueForm, T>)
+				{
+					form->value = static_cast<std::int32_t>(a_rng() % 1000);
+					form->weight = static_cast<float>(a_rng() % 100) / 10.0F;
+				}
+
+				if constexpr (std::is_same_v<T, RE::TESObjectMISC>)
+				{
+					form->componentData = (a_rng() % 3 == 0) ? std::addressof(components) : nullptr;
+					form->looseMod = (a_rng() % 5 == 0);
+				}
+
+				// Forms without a file are skipped, later files in the list override the first
+				if (a_rng() % 50 != 0)
+				{
+					auto& sourceFiles = sources.emplace_back(new std::vector<RE::TESFile*>{ files[origin].get() });
+					for (auto later = origin + 1; later < files.size(); later++)
+					{
+						if (overrideOdds && a_rng() % overrideOdds == 0)
+						{
+							sourceFiles->push_back(files[later].get());
+						}
+					}
+
+					form->sourceFiles.array = sourceFiles.get();
+					indexedCount += file.active && (form->playable || !ChecksPlayable<T>()) && (std::is_same_v<T, RE::TESLevItem> || !form->fullName.empty());
+				}
+
+				if (file.active)
+				{
+					forms.emplace(form->formID, form.get());
+				}
+
+				array.push_back(form.get());
+				storage.push_back(std::move(form));
+				formCount++;
+			}
+		}
+
+		std::vector<std::unique_ptr<RE::TESFile>> files;
+		std::vector<std::unique_ptr<std::vector<RE::TESFile*>>> sources;
+		std::vector<std::uint32_t> nextFormIDs;
+		std::vector<std::function<void()>> clears;
+		std::unordered_map<std::uint32_t, const RE::TESForm*> forms;
+		std::vector<int> components{ 1 };
+		std::size_t formCount{ 0 };
+		std::size_t indexedCount{ 0 };
+		std::uint8_t fullCount{ 0 };
+		std::uint16_t lightCount{ 0 };
+		std::uint32_t overrideOdds{ 0 };
+	};
+
+	// Waits for the background build the way the menu does, by polling the published snapshot
+	std::shared_ptr<const PluginExplorer::Snapshot> Build(std::int64_t a_threads)
+	{
+		Settings::ExplorerIndexThreads.value = a_threads;
+		PluginExplorer::Initialize();
+		while (!PluginExplorer::IsReady())
+		{
+			std::this_thread::sleep_for(1ms);
+		}
+
+		return PluginExplorer::GetSnapshot();
+	}
+
+	// Every form's override list has to be the active files after its first one, as plugin indices in load order,
+	// without the plugin the form comes from
+	std::size_t CountOverrideMismatches(const LoadOrder& a_loadOrder, const PluginExplorer::Snapshot& a_snapshot)
+	{
+		std::unordered_map<std::uint32_t, std::uint32_t> plugins;
+		auto pluginList = a_snapshot.GetPluginList();
+		for (std::uint32_t i = 0; i < pluginList.size(); i++)
+		{
+			plugins.emplace(pluginList[i].GetKey().GetValue(), i);
+		}
+
+		std::size_t mismatches{ 0 };
+		std::vector<std::uint32_t> expected;
+		for (std::uint32_t plugin = 0; plugin < pluginList.size(); plugin++)
+		{
+			for (std::uint32_t category = 0; category < Menus::FormIndex::CATEGORY_COUNT; category++)
+			{
+				auto forms = pluginList[plugin].GetForms(static_cast<Menus::FormCategory>(category));
+				for (std::uint32_t pos = 0; pos < forms.size(); pos++)
+				{
+					auto form = a_loadOrder.Find(forms[pos].first);
+					if (!form)
+					{
+						mismatches++;
+						continue;
+					}
+
+					expected.clear();
+					for (std::size_t i = 1; i < form->sourceFiles.array->size(); i++)
+					{
+						auto iter = plugins.find(PluginExplorer::PluginKey{ (*form->sourceFiles.array)[i] }.GetValue());
+						if (iter != plugins.end() && iter->second != plugin)
+						{
+							expected.push_back(iter->second);
+						}
+					}
+
+					mismatches += !std::ranges::equal(forms.overrides_of(pos), expected);
+				}
+			}
+		}
+
+		return mismatches;
+	}
+
+	// Forms are listed by full name, and leveled lists by editor ID or, once that is stripped, by their plugin's file
+	// name and FormID label
+	std::size_t CountNameMismatches(const LoadOrder& a_loadOrder, const Menus::FormIndex& a_formIndex)
+	{
+		std::size_t mismatches{ 0 };
+		for (std::uint32_t category = 0; category < Menus::FormIndex::CATEGORY_COUNT; category++)
+		{
+			for (auto [formID, name] : a_formIndex.GetForms(static_cast<Menus::FormCategory>(category)))
+			{
+				auto form = a_loadOrder.Find(formID);
+				auto expected = form ? fmt::format("{:s} [{:08X}]", form->GetFile(0)->filename, formID) : ""s;
+				if (form && !form->fullName.empty())
+				{
+					expected = form->fullName;
+				}
+				else if (form && !form->editorID.empty())
+				{
+					expected = form->editorID;
+				}
+
+				mismatches += name != expected;
+			}
+		}
+
+		return mismatches;
+	}
+
+	int Test(const LoadOrder& a_loadOrder)
+	{
+		auto reference = Build(1);
+		auto referenceImage = reference->GetFormIndex().GetImage();
+		std::printf(
+			"1 thread: %zu of %zu forms indexed from %zu plugins\n",
+			reference->GetFormIndex().GetFormCount(),
+			a_loadOrder.GetFormCount(),
+			reference->GetPluginList().size());
+
+		int failures{ 0 };
+		if (reference->GetFormIndex().GetFormCount() != a_loadOrder.GetIndexedCount())
+		{
+			std::printf("FAIL expected %zu forms indexed\n", a_loadOrder.GetIndexedCount());
+			failures++;
+		}
+
+		auto& formIndex = reference->GetFormIndex();
+		std::printf("  by category:");
+		for (std::uint32_t category = 0; category < Menus::FormIndex::CATEGORY_COUNT; category++)
+		{
+			auto count = formIndex.GetForms(static_cast<Menus::FormCategory>(category)).size();
+			std::printf(" %s %u", Menus::FormIndex::CATEGORY_NAMES[category].data(), count);
+			if (count == 0)
+			{
+				std::printf(" (EMPTY)");
+				failures++;
+			}
+		}
+
+		std::printf("\n");
+		if (auto mismatches = CountNameMismatches(a_loadOrder, formIndex); mismatches != 0)
+		{
+			std::printf("FAIL %zu forms are listed under the wrong name\n", mismatches);
+			failures++;
+		}
+
+		if (auto mismatches = CountOverrideMismatches(a_loadOrder, *reference); mismatches != 0)
+		{
+			std::printf("FAIL %zu override lists differ from the load order\n", mismatches);
+			failures++;
+		}
+
+		// A stat the form type has no component for is NaN, so "value <= 10" only finds forms that have a value
+		Menus::FormQuery query;
+		query.Add(Menus::FormStat::kValue, -std::numeric_limits<float>::infinity(), 10.0F);
+		std::size_t missingMatches{ 0 };
+		for (auto category : { Menus::FormRegistry::Get<Menus::FormTypes::FLOR>(),
+				 Menus::FormRegistry::Get<Menus::FormTypes::LVLI>(),
+				 Menus::FormRegistry::Get<Menus::FormTypes::NPC_>(),
+				 Menus::FormRegistry::Get<Menus::FormTypes::OMOD>() })
+		{
+			auto forms = formIndex.GetForms(category);
+			missingMatches += query.Run(forms).size();
+			missingMatches += std::ranges::count_if(forms.stats_of(Menus::FormStat::kWeight), [](float a_weight) { return !std::isnan(a_weight); });
+		}
+
+		auto alchemy = formIndex.GetForms(Menus::FormRegistry::Get<Menus::FormTypes::ALCH>());
+		auto cheapAlchemy = std::ranges::count_if(alchemy.stats_of(Menus::FormStat::kValue), [](float a_value) { return a_value <= 10.0F; });
+		if (missingMatches != 0 || cheapAlchemy == 0 || query.Run(alchemy).size() != static_cast<std::size_t>(cheapAlchemy))
+		{
+			std::printf("FAIL value <= 10 matched %zu forms without stats, %zu of %zd cheap ALCH forms\n", missingMatches, query.Run(alchemy).size(), cheapAlchemy);
+			failures++;
+		}
+
+		std::vector<std::int64_t> threadCounts{ 2, 3, 8 };
+		if (auto hardware = std::thread::hardware_concurrency(); hardware > 8)
+		{
+			threadCounts.push_back(hardware);
+		}
+
+		for (auto threads : threadCounts)
+		{
+			auto snapshot = Build(threads);
+			auto isEqual = std::ranges::equal(snapshot->GetFormIndex().GetImage(), referenceImage);
+			std::printf("%lld threads: %s\n", static_cast<long long>(threads), isEqual ? "identical image" : "IMAGE DIFFERS");
+			failures += !isEqual;
+		}
+
+		// The build works from copies of the game's arrays, so they may grow and move while it runs
+		Settings::ExplorerIndexThreads.value = 8;
+		PluginExplorer::Initialize();
+		auto& weapons = RE::TESDataHandler::GetSingleton()->GetFormArray<RE::TESObjectWEAP>();
+		auto weaponCount = weapons.size();
+		std::vector<RE::TESFile*> extraFiles{ RE::TESDataHandler::GetSingleton()->files.front() };
+		RE::TESObjectWEAP extra{};
+		extra.formID = 0xFFFFFF;
+		extra.fullName = "Added after Initialize";
+		extra.playable = true;
+		extra.sourceFiles.array = std::addressof(extraFiles);
+		weapons.resize(weapons.capacity() * 4 + 1, std::addressof(extra));
+		weapons.shrink_to_fit();
+		while (!PluginExplorer::IsReady())
+		{
+			std::this_thread::sleep_for(1ms);
+		}
+
+		weapons.resize(weaponCount);
+		auto isEqual = std::ranges::equal(PluginExplorer::GetSnapshot()->GetFormIndex().GetImage(), referenceImage);
+		std::printf("arrays reallocated during the build: %s\n", isEqual ? "identical image" : "IMAGE DIFFERS");
+		failures += !isEqual;
+
+		// Names and the playable flag come from the game's virtuals, which the workers must leave to its thread
+		if (auto calls = RE::offThreadCalls.load(); calls != 0)
+		{
+			std::printf("FAIL %zu game virtuals called off the game's thread\n", calls);
+			failures++;
+		}
+
+		PluginExplorer::Reset();
+		return failures;
+	}
+
+	// A FormID's top byte is its plugin's compile index, or 0xFE followed by a 12-bit light index
+	std::uint32_t GetKeyValue(std::uint32_t a_formID)
+	{
+		return ((a_formID >> 24) == 0xFE) ? (a_formID >> 12) : ((a_formID >> 24) << 12);
+	}
+
+	// A light-heavy load order: every plugin gets its own key, slot and label, and every form lands in the plugin
+	// that added it. The old key, compileIndex + smallFileCompileIndex, is counted on the same files for comparison.
+	int TestPluginKeys(std::size_t a_forms)
+	{
+		constexpr std::size_t FULL_PLUGINS{ 0xFE };
+		constexpr std::size_t LIGHT_PLUGINS{ 4000 };
+
+		LoadOrder loadOrder{ a_forms, FULL_PLUGINS + LIGHT_PLUGINS, FULL_PLUGINS };
+		auto snapshot = Build(0);
+		auto pluginList = snapshot->GetPluginList();
+
+		int failures{ 0 };
+		std::vector<bool> slots(PluginExplorer::PluginKey::SLOT_COUNT);
+		std::vector<std::uint32_t> values;
+		std::size_t misplaced{ 0 };
+		std::size_t mislabelled{ 0 };
+		for (std::size_t i = 0; i < pluginList.size(); i++)
+		{
+			auto& file = *loadOrder.GetFiles()[i];
+			auto key = pluginList[i].GetKey();
+			slots[key.GetSlot()] = true;
+			values.push_back(key.GetValue());
+
+			auto expected = fmt::format("[{:02X}]", file.compileIndex);
+			if (file.compileIndex == 0xFE)
+			{
+				expected = fmt::format("[FE][{:03X}]", file.smallFileCompileIndex);
+			}
+
+			mislabelled += Menus::FormLabel::Plugin(key.GetCompileIndex(), key.GetLightIndex()).view() != expected;
+
+			for (std::uint32_t category = 0; category < Menus::FormIndex::CATEGORY_COUNT; category++)
+			{
+				for (auto [formID, name] : pluginList[i].GetForms(static_cast<Menus::FormCategory>(category)))
+				{
+					misplaced += GetKeyValue(formID) != key.GetValue();
+				}
+			}
+		}
+
+		std::ranges::sort(values);
+		auto distinctValues = static_cast<std::size_t>(std::ranges::unique(values).begin() - values.begin());
+		auto distinctSlots = static_cast<std::size_t>(std::ranges::count(slots, true));
+		std::printf(
+			"%zu full and %zu light plugins: %zu distinct slots, %zu distinct keys, %zu mislabelled, %zu of %zu forms misplaced\n",
+			FULL_PLUGINS,
+			LIGHT_PLUGINS,
+			distinctSlots,
+			distinctValues,
+			mislabelled,
+			misplaced,
+			snapshot->GetFormIndex().GetFormCount());
+		if (pluginList.size() != FULL_PLUGINS + LIGHT_PLUGINS || distinctSlots != pluginList.size() || distinctValues != pluginList.size() ||
+			mislabelled != 0 || misplaced != 0 || snapshot->GetFormIndex().GetFormCount() != loadOrder.GetIndexedCount())
+		{
+			failures++;
+		}
+
+		// The sums stay apart while full plugins leave their light index at zero, but run past 0xFF from the third
+		// light plugin on, so the byte a FormID has room for maps them back onto full plugins
+		std::map<std::uint32_t, std::size_t> sums;
+		std::map<std::uint32_t, std::size_t> bytes;
+		for (auto& file : loadOrder.GetFiles())
+		{
+			auto sum = static_cast<std::uint32_t>(file->GetCompileIndex() + file->GetSmallFileCompileIndex());
+			sums[sum]++;
+			bytes[sum & 0xFF]++;
+		}
+
+		std::size_t sharedBytes{ 0 };
+		for (auto& [byte, count] : bytes)
+		{
+			sharedBytes += (count > 1) ? count : 0;
+		}
+
+		std::printf("  old keys: %zu distinct sums, %zu plugins share their low byte with another\n", sums.size(), sharedBytes);
+
+		PluginExplorer::Reset();
+		return failures;
+	}
+
+	// Everything InitPluginList and ProcessForms read from a snapshot, returned as a checksum so nothing is optimized out
+	std::size_t Walk(const PluginExplorer::Snapshot& a_snapshot)
+	{
+		std::size_t checksum{ 0 };
+		for (auto& plugin : a_snapshot.GetPluginList())
+		{
+			auto key = plugin.GetKey();
+			checksum += Menus::FormLabel::Plugin(key.GetCompileIndex(), key.GetLightIndex()).view().size() + plugin.GetName().size();
+			for (std::uint32_t category = 0; category < Menus::FormIndex::CATEGORY_COUNT; category++)
+			{
+				auto forms = plugin.GetForms(static_cast<Menus::FormCategory>(category));
+				std::uint32_t pos{ 0 };
+				for (auto [formID, name] : forms)
+				{
+					checksum += Menus::FormLabel::FormID(formID).view().back() + name.size() + forms.overrides_of(pos).size();
+					checksum += (forms.stat(Menus::FormStat::kValue, pos) > forms.stat(Menus::FormStat::kWeight, pos));
+					pos++;
+				}
+			}
+		}
+
+		return checksum;
+	}
+
+	int TestAllocations()
+	{
+		Build(1);
+		auto before = allocationCount.load();
+		auto current = PluginExplorer::GetSnapshot();
+		auto checksum = Walk(*current);
+		auto allocations = allocationCount.load() - before;
+		std::printf(
+			"walking %zu forms from %zu plugins: %zu allocations (checksum %zu)\n",
+			current->GetFormIndex().GetFormCount(),
+			current->GetPluginList().size(),
+			allocations,
+			checksum);
+
+		PluginExplorer::Reset();
+		return allocations != 0;
+	}
+
+	// Only a running build may leave the menu waiting: a reset or failed build has to say so and publish nothing more
+	int TestStates()
+	{
+		using State = PluginExplorer::State;
+
+		int failures{ 0 };
+		auto Expect = [&](const char* a_name, bool a_condition)
+		{
+			if (!a_condition)
+			{
+				std::printf("FAIL %s\n", a_name);
+				failures++;
+			}
+		};
+
+		Settings::ExplorerIndexThreads.value = 8;
+		PluginExplorer::Initialize();
+		Expect("building after Initialize", PluginExplorer::GetState() == State::kBuilding || PluginExplorer::GetState() == State::kReady);
+		PluginExplorer::Reset();
+		Expect("none after a Reset that stops the build", PluginExplorer::GetState() == State::kNone && !PluginExplorer::GetSnapshot());
+
+		Build(8);
+		Expect("ready once complete", PluginExplorer::GetState() == State::kReady && PluginExplorer::IsReady());
+		PluginExplorer::Reset();
+		Expect("none after Reset", PluginExplorer::GetState() == State::kNone);
+
+		// Thrown on a worker thread, and on the build thread itself with one worker
+		auto& weapons = RE::TESDataHandler::GetSingleton()->GetFormArray<RE::TESObjectWEAP>();
+		std::vector<RE::TESFile*> throwingFiles{ RE::TESDataHandler::GetSingleton()->files.front() };
+		RE::TESObjectWEAP throwing{};
+		throwing.fullName = RE::THROWING_NAME;
+		throwing.playable = true;
+		throwing.sourceFiles.array = std::addressof(throwingFiles);
+		weapons.push_back(std::addressof(throwing));
+		for (std::int64_t threads : { 8, 1 })
+		{
+			Settings::ExplorerIndexThreads.value = threads;
+			PluginExplorer::Initialize();
+			for (auto wait = 0; wait < 10000 && PluginExplorer::GetState() == State::kBuilding; wait++)
+			{
+				std::this_thread::sleep_for(1ms);
+			}
+
+			Expect("failed when ingestion throws", PluginExplorer::GetState() == State::kFailed && !PluginExplorer::IsReady());
+			PluginExplorer::Reset();
+		}
+
+		weapons.pop_back();
+		std::printf("states: %s\n", failures ? "FAILED" : "building, ready, none after Reset, failed when ingestion throws");
+		return failures;
+	}
+
+	// Runs in a scratch directory standing in for the game directory. Stale caches go when a build starts, the new
+	// one is written under its fingerprint and mapped back by the next build, and nothing else in the folder is touched.
+	int TestCacheFiles()
+	{
+		int failures{ 0 };
+		auto Expect = [&](const char* a_name, bool a_condition)
+		{
+			if (!a_condition)
+			{
+				std::printf("FAIL %s\n", a_name);
+				failures++;
+			}
+		};
+
+		auto scratch = std::filesystem::temp_directory_path() / fmt::format("plugin_explorer_test.{}", ::getpid());
+		auto directory = scratch / "Data/F4SE/Plugins";
+		std::filesystem::create_directories(directory);
+		auto previous = std::filesystem::current_path();
+		std::filesystem::current_path(scratch);
+
+		for (auto name : { "BakaInterface_PluginExplorer.cache"sv,
+				 "BakaInterface_PluginExplorer.0123456789ABCDEF.cache"sv,
+				 "BakaInterface_PluginExplorer.0123456789ABCDEF.cache.tmp"sv,
+				 "BakaInterface_PluginExplorer.jsonl"sv,
+				 "BakaInterface_PerkIcons.cache"sv })
+		{
+			std::ofstream{ directory / name } << "stale";
+		}
+
+		auto ListFiles = [&]()
+		{
+			std::vector<std::string> names;
+			for (auto& entry : std::filesystem::directory_iterator{ directory })
+			{
+				names.push_back(entry.path().filename().string());
+			}
+
+			std::ranges::sort(names);
+			return names;
+		};
+
+		Settings::EnableExplorerIndexCache.value = true;
+		auto built = Build(8);
+		PluginExplorer::Reset();
+
+		auto names = ListFiles();
+		auto cacheCount = std::ranges::count_if(names, [](const std::string& a_name) { return a_name.ends_with(".cache") && a_name.starts_with("BakaInterface_PluginExplorer."); });
+		Expect("stale caches removed", names.size() == 3 && cacheCount == 1);
+		Expect("other files kept", std::ranges::count(names, "BakaInterface_PluginExplorer.jsonl"s) == 1 && std::ranges::count(names, "BakaInterface_PerkIcons.cache"s) == 1);
+
+		auto mapped = Build(8);
+		auto builtImage = built->GetFormIndex().GetImage().subspan(sizeof(Menus::FormIndex::Header));
+		auto mappedImage = mapped->GetFormIndex().GetImage().subspan(sizeof(Menus::FormIndex::Header));
+		auto mappedHeader = reinterpret_cast<const Menus::FormIndex::Header*>(mapped->GetFormIndex().GetImage().data());
+		Expect("next build maps the cache", mappedHeader->fingerprint != 0);
+		Expect("cache maps back the built index", std::ranges::equal(builtImage, mappedImage));
+		PluginExplorer::Reset();
+		Expect("mapped cache kept", ListFiles() == names);
+
+		Settings::EnableExplorerIndexCache.value = false;
+		std::filesystem::current_path(previous);
+		std::filesystem::remove_all(scratch);
+
+		std::printf("cache files: %s\n", failures ? "FAILED" : "stale caches removed, versioned cache written and mapped back");
+		return failures;
+	}
+
+	using LegacyFormMap = std::map<std::uint32_t, std::string_view>;
+
+	struct LegacyPlugin
+	{
+		std::string_view name;
+		std::array<LegacyFormMap, Menus::FormIndex::CATEGORY_COUNT> maps;
+	};
+
+	// What Initialize did before the columnar index, for every category the registry now has: each form's plugin is
+	// found in a std::map keyed by compile index plus light index, and the form goes into that plugin's std::map
+	template<class CATEGORY>
+	void AddLegacyForms(std::map<std::uint32_t, LegacyPlugin>& a_modMap)
+	{
+		auto category = stl::to_underlying(Menus::FormRegistry::Get<CATEGORY>());
+		for (auto form : RE::TESDataHandler::GetSingleton()->GetFormArray<typename CATEGORY::form_type>())
+		{
+			auto file = form->GetFile(0);
+			if (file && file->compileIndex < 0xFF)
+			{
+				auto info = a_modMap.find(static_cast<std::uint32_t>(file->GetCompileIndex() + file->GetSmallFileCompileIndex()));
+				auto formName = RE::TESFullName::GetFullName(*form);
+				if (info != a_modMap.end() && form->GetPlayable(nullptr) && !formName.empty())
+				{
+					info->second.maps[category].insert_or_assign(form->GetFormID(), formName);
+				}
+			}
+		}
+	}
+
+	using LegacyTimes = std::array<std::chrono::steady_clock::duration, Menus::FormIndex::CATEGORY_COUNT>;
+
+	std::size_t BuildLegacy(std::map<std::uint32_t, LegacyPlugin>& a_modMap, LegacyTimes& a_times)
+	{
+		a_modMap.clear();
+		for (auto file : RE::TESDataHandler::GetSingleton()->files)
+		{
+			if (file->IsActive())
+			{
+				a_modMap.insert_or_assign(static_cast<std::uint32_t>(file->GetCompileIndex() + file->GetSmallFileCompileIndex()), LegacyPlugin{ file->GetFilename(), {} });
+			}
+		}
+
+		Menus::FormRegistry::ForEach(
+			[&]<class CATEGORY>()
+			{
+				if constexpr (!std::is_void_v<typename CATEGORY::form_type>)
+				{
+					auto start = std::chrono::steady_clock::now();
+					AddLegacyForms<CATEGORY>(a_modMap);
+					a_times[stl::to_underlying(Menus::FormRegistry::Get<CATEGORY>())] = std::chrono::steady_clock::now() - start;
+				}
+			});
+
+		std::size_t formCount{ 0 };
+		for (auto& [key, plugin] : a_modMap)
+		{
+			for (auto& map : plugin.maps)
+			{
+				formCount += map.size();
+			}
+		}
+
+		return formCount;
+	}
+
+	template<class FUNC>
+	double Time(int a_passes, FUNC a_func)
+	{
+		double best{ 0.0 };
+		for (int pass = 0; pass < a_passes; pass++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			a_func();
+			auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			best = (pass == 0) ? seconds : std::min(best, seconds);
+		}
+
+		return best;
+	}
+
+	void Bench(int a_passes)
+	{
+		auto threads = static_cast<std::int64_t>(std::max(std::thread::hardware_concurrency(), 1u));
+		std::shared_ptr<const PluginExplorer::Snapshot> snapshot;
+		auto serialSeconds = Time(a_passes, [&]() { snapshot = Build(1); });
+		auto parallelSeconds = Time(a_passes, [&]() { snapshot = Build(threads); });
+
+		// What the game's thread waits for: copying the arrays, names and flags before the build starts
+		double initializeSeconds{ 0.0 };
+		for (int pass = 0; pass < a_passes; pass++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			PluginExplorer::Initialize();
+			auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			initializeSeconds = (pass == 0) ? seconds : std::min(initializeSeconds, seconds);
+			PluginExplorer::Reset();
+		}
+
+		// One more build with the log shown, for where the time goes. On one thread, the per-type ingestion times
+		// compare directly with the std::map path below.
+		logger::verbose = true;
+		snapshot = Build(1);
+		logger::verbose = false;
+
+		auto formCount = snapshot->GetFormIndex().GetFormCount();
+		auto& formIndex = snapshot->GetFormIndex();
+		std::printf(
+			"index: %zu forms, Initialize to complete %.1fms on 1 thread, %.1fms on %lld, %.1fms on the game's thread\n",
+			formCount,
+			serialSeconds * 1e3,
+			parallelSeconds * 1e3,
+			static_cast<long long>(threads),
+			initializeSeconds * 1e3);
+		auto header = reinterpret_cast<const Menus::FormIndex::Header*>(formIndex.GetImage().data());
+		auto overrideBytes = header->overrideCount * sizeof(std::uint32_t);
+		auto columnBytes = formIndex.GetByteSize() - header->nameBytes - overrideBytes;
+		std::printf(
+			"  %.1f bytes/form in the index: %.1f in columns and ranges, %.1f in names, %.1f in override lists\n",
+			static_cast<double>(formIndex.GetByteSize()) / formCount,
+			static_cast<double>(columnBytes) / formCount,
+			static_cast<double>(header->nameBytes) / formCount,
+			static_cast<double>(overrideBytes) / formCount);
+		std::printf("  %.1f bytes/form with the search index\n", static_cast<double>(snapshot->GetByteSize()) / formCount);
+		snapshot.reset();
+		PluginExplorer::Reset();
+
+		std::map<std::uint32_t, LegacyPlugin> modMap;
+		std::size_t legacyCount{ 0 };
+		std::size_t legacyBytes{ 0 };
+		LegacyTimes legacyTimes{};
+		LegacyTimes times{};
+		auto legacySeconds = Time(
+			a_passes,
+			[&]()
+			{
+				auto before = allocatedBytes.load();
+				legacyCount = BuildLegacy(modMap, times);
+				legacyBytes = allocatedBytes.load() - before;
+				for (std::size_t i = 0; i < times.size(); i++)
+				{
+					legacyTimes[i] = (legacyTimes[i] == legacyTimes[i].zero()) ? times[i] : std::min(legacyTimes[i], times[i]);
+				}
+			});
+
+		// Colliding keys put several plugins' forms in one map and lose the others, so the counts differ.
+		// Names were views of the game's own strings, so the maps hold no name bytes.
+		std::printf(
+			"legacy maps: %zu forms in %.1fms, %.1f bytes/form in map nodes\n",
+			legacyCount,
+			legacySeconds * 1e3,
+			legacyCount ? static_cast<double>(legacyBytes) / legacyCount : 0.0);
+		for (std::uint32_t category = 0; category < Menus::FormIndex::CATEGORY_COUNT; category++)
+		{
+			if (legacyTimes[category] != legacyTimes[category].zero())
+			{
+				std::printf(
+					"  %s forms in %lldus\n",
+					Menus::FormIndex::CATEGORY_NAMES[category].data(),
+					static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(legacyTimes[category]).count()));
+			}
+		}
+	}
+	// Override lists are built in one pass over each form's files, so the build should grow with the number of
+	// (form, file) pairs and nothing else: the same forms are built with later plugins overriding more and more
+	int BenchOverrides(std::size_t a_forms, std::size_t a_plugins, int a_passes)
+	{
+		int failures{ 0 };
+		double baseSeconds{ 0.0 };
+		std::size_t basePairs{ 0 };
+		for (std::uint32_t odds : { 0u, 64u, 16u, 4u })
+		{
+			LoadOrder loadOrder{ a_forms, a_plugins, 0, odds };
+			std::shared_ptr<const PluginExplorer::Snapshot> snapshot;
+			auto seconds = Time(a_passes, [&]() { snapshot = Build(1); });
+
+			auto& formIndex = snapshot->GetFormIndex();
+			auto header = reinterpret_cast<const Menus::FormIndex::Header*>(formIndex.GetImage().data());
+			std::size_t pairs = formIndex.GetFormCount() + header->overrideCount;
+			auto mismatches = CountOverrideMismatches(loadOrder, *snapshot);
+			failures += mismatches != 0;
+			if (odds == 0)
+			{
+				baseSeconds = seconds;
+				basePairs = pairs;
+				std::printf("overrides: none, %zu (form, file) pairs in %.1fms\n", pairs, seconds * 1e3);
+			}
+			else
+			{
+				std::printf(
+					"overrides: 1 in %u, %zu (form, file) pairs in %.1fms, %.1fns per added pair, %zu lists differ\n",
+					odds,
+					pairs,
+					seconds * 1e3,
+					(seconds - baseSeconds) * 1e9 / static_cast<double>(pairs - basePairs),
+					mismatches);
+			}
+
+			snapshot.reset();
+			PluginExplorer::Reset();
+		}
+
+		return failures;
+	}
+}
+
+int main(int a_argc, char** a_argv)
+{
+	auto forms = (a_argc > 1) ? std::strtoull(a_argv[1], nullptr, 10) : 200000;
+	auto plugins = (a_argc > 2) ? std::strtoull(a_argv[2], nullptr, 10) : 300;
+	auto passes = (a_argc > 3) ? std::max(std::atoi(a_argv[3]), 1) : 3;
+	if (forms == 0 || plugins == 0)
+	{
+		std::fprintf(stderr, "usage: %s [forms] [plugins] [passes]\n", a_argv[0]);
+		return 1;
+	}
+
+	auto failures = TestPluginKeys(forms);
+	{
+		LoadOrder loadOrder{ forms, plugins };
+		failures += Test(loadOrder);
+		failures += TestAllocations();
+		failures += TestStates();
+		failures += TestCacheFiles();
+		Bench(passes);
+	}
+
+	failures += BenchOverrides(forms, plugins, passes);
+
+	std::printf(failures ? "%d FAILED\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,281 @@
+// Stand-ins for the logger, settings and game types the PluginExplorer headers use, so the scripts can include them
+// off the game machine. Only what the headers touch is declared, with plain members the tests fill in directly.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <fmt/format.h>
+
+using namespace std::literals;
+
+namespace stl
+{
+	template<class ENUM>
+	constexpr auto to_underlying(ENUM a_value) noexcept
+	{
+		return static_cast<std::underlying_type_t<ENUM>>(a_value);
+	}
+}
+
+namespace logger
+{
+	inline std::atomic<bool> verbose{ false };
+
+	template<class... ARGS>
+	void debug(fmt::format_string<ARGS...> a_format, ARGS&&... a_args)
+	{
+		if (verbose)
+		{
+			fmt::print("  {:s}\n", fmt::format(a_format, std::forward<ARGS>(a_args)...));
+		}
+	}
+
+	template<class... ARGS>
+	void warn(ARGS&&...)
+	{}
+
+	template<class... ARGS>
+	void error(ARGS&&...)
+	{}
+}
+
+namespace Version
+{
+	inline constexpr auto PROJECT{ "BakaInterface"sv };
+}
+
+class Settings
+{
+public:
+	template<class T>
+	struct Setting
+	{
+		const T& operator*() const noexcept { return value; }
+
+		T value;
+	};
+
+	static inline Setting<std::int64_t> ExplorerIndexThreads{ 0 };
+	static inline Setting<bool> EnableExplorerIndexCache{ false };
+};
+
+namespace RE
+{
+	enum class ENUM_FORM_ID : std::uint8_t
+	{
+		kALCH,
+		kAMMO,
+		kARMO,
+		kBOOK,
+		kFLOR,
+		kNOTE,
+		kINGR,
+		kKEYM,
+		kLVLI,
+		kMISC,
+		kNPC_,
+		kOMOD,
+		kWEAP
+	};
+
+	struct TESFile
+	{
+		bool IsActive() const { return active; }
+		std::string_view GetFilename() const { return filename; }
+		std::uint8_t GetCompileIndex() const { return compileIndex; }
+		std::uint16_t GetSmallFileCompileIndex() const { return smallFileCompileIndex; }
+
+		std::string filename;
+		std::uint8_t compileIndex;
+		std::uint16_t smallFileCompileIndex;
+		bool active;
+	};
+
+	// The game's virtuals are only safe to call on its own thread, calls from any other are counted
+	inline const std::thread::id GAME_THREAD{ std::this_thread::get_id() };
+	inline std::atomic<std::size_t> offThreadCalls{ 0 };
+
+	inline void CheckGameThread()
+	{
+		if (std::this_thread::get_id() != GAME_THREAD)
+		{
+			offThreadCalls++;
+		}
+	}
+
+	// A form with this name throws, the way a bad form or a failed allocation would
+	inline constexpr auto THROWING_NAME{ "Throws during ingestion"sv };
+
+	struct TESForm
+	{
+		TESFile* GetFile(std::int32_t a_index) const
+		{
+			if (fullName == THROWING_NAME)
+			{
+				throw std::runtime_error("synthetic ingestion failure");
+			}
+
+			return (sourceFiles.array && a_index < static_cast<std::int32_t>(sourceFiles.array->size())) ? (*sourceFiles.array)[a_index] : nullptr;
+		}
+
+		const char* GetFormEditorID() const
+		{
+			CheckGameThread();
+			return editorID.c_str();
+		}
+
+		bool GetPlayable(const void*) const
+		{
+			CheckGameThread();
+			return playable;
+		}
+
+		std::uint32_t GetFormID() const { return formID; }
+
+		std::uint32_t formID;
+		std::string fullName;
+		std::string editorID;
+		bool playable;
+		struct
+		{
+			std::vector<TESFile*>* array;
+		} sourceFiles;
+	};
+
+	struct TESFullName
+	{
+		static std::string_view GetFullName(const TESForm& a_form)
+		{
+			CheckGameThread();
+			return a_form.fullName;
+		}
+	};
+
+	struct TESValueForm
+	{
+		std::int32_t value;
+	};
+
+	struct TESWeightForm
+	{
+		float weight;
+	};
+
+	template<ENUM_FORM_ID ID>
+	struct Form : TESForm
+	{
+		static constexpr auto FORM_ID{ ID };
+	};
+
+	struct AlchemyItem : Form<ENUM_FORM_ID::kALCH>, TESValueForm, TESWeightForm
+	{};
+
+	struct TESAmmo : Form<ENUM_FORM_ID::kAMMO>, TESValueForm, TESWeightForm
+	{};
+
+	struct TESObjectARMO : Form<ENUM_FORM_ID::kARMO>
+	{
+		struct
+		{
+			std::int32_t value;
+			float weight;
+			std::uint16_t rating;
+		} armorData;
+	};
+
+	struct TESObjectBOOK : Form<ENUM_FORM_ID::kBOOK>, TESValueForm, TESWeightForm
+	{};
+
+	struct TESFlora : Form<ENUM_FORM_ID::kFLOR>
+	{};
+
+	struct BGSNote : Form<ENUM_FORM_ID::kNOTE>, TESValueForm, TESWeightForm
+	{};
+
+	struct IngredientItem : Form<ENUM_FORM_ID::kINGR>, TESValueForm, TESWeightForm
+	{};
+
+	struct TESKey : Form<ENUM_FORM_ID::kKEYM>, TESValueForm, TESWeightForm
+	{};
+
+	struct TESLevItem : Form<ENUM_FORM_ID::kLVLI>
+	{};
+
+	struct TESObjectMISC : Form<ENUM_FORM_ID::kMISC>, TESValueForm, TESWeightForm
+	{
+		bool IsLooseMod() const { return looseMod; }
+
+		std::vector<int>* componentData;
+		bool looseMod;
+	};
+
+	struct TESNPC : Form<ENUM_FORM_ID::kNPC_>
+	{};
+
+	namespace BGSMod::Attachment
+	{
+		struct Mod : Form<ENUM_FORM_ID::kOMOD>
+		{};
+	}
+
+	struct TESObjectWEAP : Form<ENUM_FORM_ID::kWEAP>, TESValueForm, TESWeightForm
+	{
+		struct
+		{
+			std::int32_t value;
+			float weight;
+			std::uint16_t attackDamage;
+		} weaponData;
+	};
+
+	struct TESDataHandler
+	{
+		static TESDataHandler* GetSingleton()
+		{
+			static TESDataHandler singleton;
+			return std::addressof(singleton);
+		}
+
+		template<class T>
+		std::vector<T*>& GetFormArray()
+		{
+			static std::vector<T*> forms;
+			return forms;
+		}
+
+		std::vector<TESFile*> files;
+	};
+
+	struct Setting
+	{
+		std::string_view GetString() const { return value; }
+
+		std::string value;
+	};
+
+	struct INISettingCollection
+	{
+		static INISettingCollection* GetSingleton()
+		{
+			static INISettingCollection singleton;
+			return std::addressof(singleton);
+		}
+
+		Setting* GetSetting(std::string_view a_name)
+		{
+			auto iter = settings.find(std::string{ a_name });
+			return (iter != settings.end()) ? std::addressof(iter->second) : nullptr;
+		}
+
+		std::map<std::string, Setting> settings;
+	};
+}
@@ -38,6 +38,7 @@ private:
 			GameSettingCollection->Add(&sBakaRanks);
 			GameSettingCollection->Add(&sBakaLevelUpText);
 			GameSettingCollection->Add(&sBakaPerkMenu);
+			GameSettingCollection->Add(&sBakaItemsAdded);
 		}
 
 		logger::debug("Injected GMSTs."sv);
@@ -72,4 +73,5 @@ public:
 	inline static RE::Setting sBakaRanks{ "sBakaRanks", "Ranks: {:d}" };
 	inline static RE::Setting sBakaLevelUpText{ "sBakaLevelUpText", "Welcome to Level {:d}" };
 	inline static RE::Setting sBakaPerkMenu{ "sBakaPerkMenu", "Perk Menu" };
+	inline static RE::Setting sBakaItemsAdded{ "sBakaItemsAdded", "{:d} items added" };
 };
@@ -0,0 +1,121 @@
+#pragma once
+
+namespace Menus
+{
+	// Condition lists compiled down to flat comparisons against a snapshot of values taken from the player.
+	// Every condition of every perk lives in one array, so a single pass evaluates all of them, and nothing
+	// here touches the game, the results only depend on the snapshot.
+	//
+	// Each block is one condition list. OR binds tighter than AND, as it does in the engine: a condition flagged OR
+	// forms a group with the conditions after it up to the first one that is not flagged, the group holds if any
+	// of its conditions does, and the block holds if every group does.
+	class ConditionProgram
+	{
+	public:
+		enum class Op : std::uint8_t
+		{
+			kEqual,
+			kNotEqual,
+			kGreater,
+			kGreaterEqual,
+			kLess,
+			kLessEqual,
+			kTrue
+		};
+
+		// The mask holds which outcomes of comparing the snapshot value against the operand pass
+		struct Instruction
+		{
+			std::uint32_t slot;
+			float value;
+			std::uint32_t block;
+			std::uint8_t mask;
+			bool isGroupEnd;
+		};
+
+		struct Results
+		{
+			std::vector<std::uint8_t> conditions;
+			std::vector<std::uint8_t> blocks;
+		};
+
+		// Instructions added after this belong to the new block
+		std::uint32_t AddBlock()
+		{
+			CloseGroup();
+			return _blockCount++;
+		}
+
+		// Returns where Run stores the result of the instruction. The slot has to be inside the snapshot, even for kTrue.
+		// An OR on the last instruction of a block is ignored.
+		std::uint32_t Add(std::uint32_t a_slot, Op a_op, float a_value, bool a_isOr)
+		{
+			assert(_blockCount > 0);
+			_instructions.push_back({ a_slot, a_value, _blockCount - 1, GetMask(a_op), !a_isOr });
+			return static_cast<std::uint32_t>(_instructions.size() - 1);
+		}
+
+		[[nodiscard]] std::size_t size() const noexcept { return _instructions.size(); }
+		[[nodiscard]] std::size_t GetBlockCount() const noexcept { return _blockCount; }
+
+		// Evaluates every instruction, and every block from those results, in one pass without branching on either
+		void Run(std::span<const float> a_snapshot, Results& a_results) const
+		{
+			a_results.conditions.resize(_instructions.size());
+			a_results.blocks.assign(_blockCount, true);
+
+			bool group{ false };
+			for (std::size_t i = 0; i < _instructions.size(); i++)
+			{
+				auto& instruction = _instructions[i];
+				auto value = a_snapshot[instruction.slot];
+				auto outcome = static_cast<std::uint8_t>(
+					(value > instruction.value) | ((value == instruction.value) << 1) | ((value < instruction.value) << 2));
+				outcome |= static_cast<std::uint8_t>((outcome == 0) << 3);
+
+				auto result = (instruction.mask & outcome) != 0;
+				auto isGroupEnd = instruction.isGroupEnd || i + 1 == _instructions.size();
+				a_results.conditions[i] = result;
+
+				group = group | result;
+				a_results.blocks[instruction.block] &= static_cast<std::uint8_t>(group | !isGroupEnd);
+				group = group & !isGroupEnd;
+			}
+		}
+
+	private:
+		// Bits for greater, equal, less and unordered, the last only happening for NaN
+		static constexpr std::uint8_t GetMask(Op a_op) noexcept
+		{
+			switch (a_op)
+			{
+				case Op::kEqual:
+					return 0b0010;
+				case Op::kNotEqual:
+					return 0b1101;
+				case Op::kGreater:
+					return 0b0001;
+				case Op::kGreaterEqual:
+					return 0b0011;
+				case Op::kLess:
+					return 0b0100;
+				case Op::kLessEqual:
+					return 0b0110;
+				default:
+					return 0b1111;
+			}
+		}
+
+		// The last instruction of a block always ends its group, so groups never span blocks
+		void CloseGroup() noexcept
+		{
+			if (!_instructions.empty())
+			{
+				_instructions.back().isGroupEnd = true;
+			}
+		}
+
+		std::vector<Instruction> _instructions;
+		std::uint32_t _blockCount{ 0 };
+	};
+}
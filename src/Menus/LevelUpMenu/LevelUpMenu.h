@@ -109,6 +109,13 @@ namespace Menus
 					}
 					break;
 
+				case 8:
+					if ((a_params.argCount == 1) && (a_params.args[0].IsUInt()))
+					{
+						GetUpcomingPerks(a_params.args[0].GetUInt());
+					}
+					break;
+
 				default:
 					break;
 			}
@@ -124,6 +131,7 @@ namespace Menus
 			MapCodeMethodToASFunction("UpdateHeader", 5);
 			MapCodeMethodToASFunction("SetTextEntry", 6);
 			MapCodeMethodToASFunction("AddPerk", 7);
+			MapCodeMethodToASFunction("GetUpcomingPerks", 8);
 		}
 
 		virtual RE::UI_MESSAGE_RESULTS ProcessMessage(RE::UIMessage& a_message) override
@@ -206,11 +214,24 @@ namespace Menus
 			RE::Scaleform::GFx::Value PerkList[1];
 			uiMovie->CreateArray(&PerkList[0]);
 
-			auto perkManager = PerkManager();
-			for (auto& perkChain : perkManager.GetPerkChains())
+			auto perkManager = PerkManager::GetSingleton();
+			auto PlayerCharacter = RE::PlayerCharacter::GetSingleton();
+			if (!perkManager || !PlayerCharacter)
 			{
-				auto perkIndex = perkChain.GetFirstAvailableRank();
-				if (perkIndex.second == -1)
+				menuObj.Invoke("SetPerkList", nullptr, PerkList, 1);
+				return;
+			}
+
+			auto& perkChains = perkManager->GetPerkChains();
+			auto& levelIndex = perkManager->GetLevelIndex();
+			auto count = PerkStates.Update(*perkManager, PlayerCharacter);
+			logger::debug(FMT_STRING("LevelUpMenu: Re-evaluated {:d} of {:d} perk chains"), count, perkChains.size());
+
+			for (std::size_t chainIndex = 0; chainIndex < perkChains.size(); chainIndex++)
+			{
+				auto states = PerkStates.GetStates(chainIndex);
+				auto rankIndex = PerkStates.GetRankIndex(chainIndex);
+				if (rankIndex == -1)
 				{
 					continue;
 				}
@@ -219,29 +240,77 @@ namespace Menus
 				uiMovie->CreateArray(&descs);
 				uiMovie->CreateArray(&paths);
 
-				for (auto& _perk : perkChain.Get())
+				auto ranks = perkChains[chainIndex].Get();
+				for (std::size_t i = 0; i < ranks.size(); i++)
 				{
-					descs.PushBack(_perk.GetConditionText().data());
-					paths.PushBack(_perk.GetPerkIcon().data());
+					descs.PushBack(states[i].conditionText.c_str());
+					paths.PushBack(ranks[i].GetPerkIcon().data());
 				}
 
+				auto& rank = ranks[rankIndex];
 				RE::Scaleform::GFx::Value listEntry;
 				uiMovie->CreateObject(&listEntry);
-				listEntry.SetMember("text", perkIndex.first.GetName().data());
+				listEntry.SetMember("text", rank.GetName().data());
 				listEntry.SetMember("RankDescs", descs);
 				listEntry.SetMember("IconPaths", paths);
-				listEntry.SetMember("PerkLevel", perkIndex.first.GetPerkLevel());
-				listEntry.SetMember("RankCount", perkIndex.first->data.numRanks);
-				listEntry.SetMember("RankIndex", perkIndex.second);
-				listEntry.SetMember("IsAvailable", perkIndex.first.IsAvailable());
+				listEntry.SetMember("PerkLevel", rank.GetPerkLevel());
+				listEntry.SetMember("RankCount", rank->data.numRanks);
+				listEntry.SetMember("RankIndex", rankIndex);
+				listEntry.SetMember("IsAvailable", PerkStates.IsAvailable(levelIndex.GetRank(chainIndex, rankIndex)));
 				listEntry.SetMember("IsSelected", false);
-				listEntry.SetMember("FormID", perkIndex.first->formID);
+				listEntry.SetMember("FormID", rank->formID);
 				PerkList[0].PushBack(listEntry);
 			}
 
 			menuObj.Invoke("SetPerkList", nullptr, PerkList, 1);
 		}
 
+		// Lists the ranks that unlock within the next a_levels levels, lowest requirement first. Only ranks the player
+		// has yet to take in chains the perk list shows are included.
+		void GetUpcomingPerks(std::uint32_t a_levels)
+		{
+			RE::Scaleform::GFx::Value UpcomingList[1];
+			uiMovie->CreateArray(&UpcomingList[0]);
+
+			auto perkManager = PerkManager::GetSingleton();
+			auto PlayerCharacter = RE::PlayerCharacter::GetSingleton();
+			if (!perkManager || !PlayerCharacter)
+			{
+				menuObj.Invoke("SetUpcomingPerks", nullptr, UpcomingList, 1);
+				return;
+			}
+
+			auto& perkChains = perkManager->GetPerkChains();
+			auto& levelIndex = perkManager->GetLevelIndex();
+			PerkStates.Update(*perkManager, PlayerCharacter);
+
+			auto level = PlayerCharacter->GetLevel();
+			auto maxLevel = static_cast<std::uint16_t>(std::min<std::uint64_t>(std::uint64_t{ level } + a_levels, std::numeric_limits<std::uint16_t>::max()));
+			for (auto rankID : levelIndex.GetUnlocks(level, maxLevel))
+			{
+				auto chainIndex = levelIndex.GetChain(rankID);
+				auto rankIndex = PerkStates.GetRankIndex(chainIndex);
+				auto index = static_cast<std::int32_t>(rankID - levelIndex.GetFirstRank(chainIndex));
+				if (rankIndex == -1 || index < rankIndex || !PerkStates.GetState(rankID).isValid)
+				{
+					continue;
+				}
+
+				auto& rank = perkChains[chainIndex].Get()[index];
+				RE::Scaleform::GFx::Value listEntry;
+				uiMovie->CreateObject(&listEntry);
+				listEntry.SetMember("text", rank.GetName().data());
+				listEntry.SetMember("IconPath", rank.GetPerkIcon().data());
+				listEntry.SetMember("PerkLevel", rank.GetPerkLevel());
+				listEntry.SetMember("RankIndex", index);
+				listEntry.SetMember("ConditionsMet", PerkStates.GetState(rankID).isTrue);
+				listEntry.SetMember("FormID", rank->formID);
+				UpcomingList[0].PushBack(listEntry);
+			}
+
+			menuObj.Invoke("SetUpcomingPerks", nullptr, UpcomingList, 1);
+		}
+
 		void GetPerkCount()
 		{
 			if (auto PlayerCharacter = RE::PlayerCharacter::GetSingleton(); PlayerCharacter)
@@ -288,6 +357,7 @@ namespace Menus
 
 		RE::msvc::unique_ptr<RE::BSGFxShaderFXTarget> Background_mc{ nullptr };
 		static inline std::string HeaderText;
+		static inline PerkManager::PerkListState PerkStates;
 		static inline bool FromPipboy{ false };
 		static inline bool IsNewLevel{ false };
 		static inline bool IsLoaded{ false };
@@ -0,0 +1,210 @@
+#pragma once
+
+namespace Menus
+{
+	// Splits perks into rank chains by following nextPerk. Perks are found through a flat formID hash table and every
+	// link is followed once, so resolving every chain costs O(ranks) however long the chains are.
+	//
+	// A chain starts at a rank nothing links to and runs until a rank without a next one. A chain that only links back
+	// to itself starts at its lowest level rank. A link into another chain, or into the middle of its own, is malformed:
+	// the chain ends at the rank with that link, so every rank belongs to exactly one chain.
+	class PerkGraph
+	{
+	public:
+		static constexpr std::uint32_t NONE{ static_cast<std::uint32_t>(-1) };
+
+		// Ranks that are not listed themselves still belong to the chains that link to them.
+		// Chains come out in the order of the lowest formID they list.
+		void Build(std::vector<RE::BGSPerk*> a_perks)
+		{
+			std::ranges::sort(a_perks, {}, [](const RE::BGSPerk* a_perk) { return a_perk->formID; });
+			auto duplicates = std::ranges::unique(a_perks);
+			a_perks.erase(duplicates.begin(), duplicates.end());
+
+			_nodes.clear();
+			_nodes.reserve(a_perks.size());
+			_table.assign(std::bit_ceil(std::max<std::size_t>(a_perks.size() * 2, 16)), NONE);
+			_malformedCount = 0;
+
+			for (auto perk : a_perks)
+			{
+				Insert(perk);
+			}
+
+			for (std::uint32_t i = 0; i < _nodes.size(); i++)
+			{
+				if (auto next = _nodes[i].perk->nextPerk; next)
+				{
+					auto slot = Insert(next);
+					_nodes[i].next = slot;
+					_nodes[slot].predecessors++;
+				}
+			}
+
+			Resolve(static_cast<std::uint32_t>(a_perks.size()));
+		}
+
+		[[nodiscard]] std::size_t size() const noexcept { return _offsets.empty() ? 0 : _offsets.size() - 1; }
+		[[nodiscard]] std::size_t GetRankCount() const noexcept { return _ranks.size(); }
+		[[nodiscard]] std::size_t GetMalformedCount() const noexcept { return _malformedCount; }
+
+		std::span<RE::BGSPerk* const> operator[](std::size_t a_chain) const noexcept
+		{
+			return { _ranks.data() + _offsets[a_chain], _ranks.data() + _offsets[a_chain + 1] };
+		}
+
+	private:
+		struct Node
+		{
+			RE::BGSPerk* perk;
+			std::uint32_t next{ NONE };
+			std::uint32_t chain{ NONE };
+			std::uint32_t predecessors{ 0 };
+		};
+
+		static std::uint32_t Hash(std::uint32_t a_formID) noexcept
+		{
+			return a_formID * 0x9E3779B1u;
+		}
+
+		// Returns the node of the perk, adding it if it is not in the graph yet
+		std::uint32_t Insert(RE::BGSPerk* a_perk)
+		{
+			if ((_nodes.size() + 1) * 2 > _table.size())
+			{
+				Grow();
+			}
+
+			auto mask = _table.size() - 1;
+			for (auto i = Hash(a_perk->formID) & mask;; i = (i + 1) & mask)
+			{
+				if (_table[i] == NONE)
+				{
+					_table[i] = static_cast<std::uint32_t>(_nodes.size());
+					_nodes.push_back({ a_perk });
+					return _table[i];
+				}
+
+				if (_nodes[_table[i]].perk->formID == a_perk->formID)
+				{
+					return _table[i];
+				}
+			}
+		}
+
+		void Grow()
+		{
+			_table.assign(_table.size() * 2, NONE);
+			auto mask = _table.size() - 1;
+			for (std::uint32_t slot = 0; slot < _nodes.size(); slot++)
+			{
+				auto i = Hash(_nodes[slot].perk->formID) & mask;
+				while (_table[i] != NONE)
+				{
+					i = (i + 1) & mask;
+				}
+
+				_table[i] = slot;
+			}
+		}
+
+		void Resolve(std::uint32_t a_listedCount)
+		{
+			std::vector<std::uint32_t> slots;
+			std::vector<std::uint32_t> offsets{ 0 };
+			slots.reserve(_nodes.size());
+
+			for (std::uint32_t i = 0; i < _nodes.size(); i++)
+			{
+				if (_nodes[i].predecessors == 0)
+				{
+					Claim(i, slots, offsets);
+				}
+			}
+
+			// Whatever is left sits on a cycle that nothing outside of it links to. Each one holds a listed perk,
+			// and the first one found has the lowest formID on its cycle.
+			for (std::uint32_t i = 0; i < a_listedCount; i++)
+			{
+				if (_nodes[i].chain != NONE)
+				{
+					continue;
+				}
+
+				auto start = i;
+				for (auto slot = _nodes[i].next; slot != i; slot = _nodes[slot].next)
+				{
+					if (_nodes[slot].perk->data.level < _nodes[start].perk->data.level)
+					{
+						start = slot;
+					}
+				}
+
+				Claim(start, slots, offsets);
+			}
+
+			_ranks.clear();
+			_ranks.reserve(slots.size());
+			_offsets.assign(1, 0);
+
+			std::vector<bool> isEmitted(offsets.size() - 1, false);
+			for (std::uint32_t i = 0; i < a_listedCount; i++)
+			{
+				auto chain = _nodes[i].chain;
+				if (isEmitted[chain])
+				{
+					continue;
+				}
+
+				isEmitted[chain] = true;
+				for (auto j = offsets[chain]; j < offsets[chain + 1]; j++)
+				{
+					_ranks.push_back(_nodes[slots[j]].perk);
+				}
+
+				// A perk with ranks of its own, rather than a perk per rank, is listed once for each
+				if (auto perk = _ranks.back(); offsets[chain + 1] - offsets[chain] == 1 && !perk->nextPerk)
+				{
+					for (auto rank = 1; rank < perk->data.numRanks; rank++)
+					{
+						_ranks.push_back(perk);
+					}
+				}
+
+				_offsets.push_back(static_cast<std::uint32_t>(_ranks.size()));
+			}
+		}
+
+		void Claim(std::uint32_t a_start, std::vector<std::uint32_t>& a_slots, std::vector<std::uint32_t>& a_offsets)
+		{
+			auto chain = static_cast<std::uint32_t>(a_offsets.size() - 1);
+			for (auto slot = a_start; slot != NONE; slot = _nodes[slot].next)
+			{
+				if (_nodes[slot].chain != NONE)
+				{
+					if (slot != a_start)
+					{
+						_malformedCount++;
+						logger::debug(
+							FMT_STRING("PerkGraph: [{:08X}] links into the middle of a chain at [{:08X}]"),
+							_nodes[a_slots.back()].perk->formID,
+							_nodes[slot].perk->formID);
+					}
+
+					break;
+				}
+
+				_nodes[slot].chain = chain;
+				a_slots.push_back(slot);
+			}
+
+			a_offsets.push_back(static_cast<std::uint32_t>(a_slots.size()));
+		}
+
+		std::vector<Node> _nodes;
+		std::vector<std::uint32_t> _table;
+		std::vector<RE::BGSPerk*> _ranks;
+		std::vector<std::uint32_t> _offsets;
+		std::size_t _malformedCount{ 0 };
+	};
+}
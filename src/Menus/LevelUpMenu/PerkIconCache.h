@@ -0,0 +1,196 @@
+#pragma once
+#include "Menus/Utils/Fingerprint/Fingerprint.h"
+
+namespace Menus
+{
+	// Remembers which icon each perk resolved to, so the filesystem is probed at most once per perk while the game data is loaded.
+	// Icons that were found are also kept on disk while the load order is unchanged, letting later sessions skip probing them.
+	// Perks without an icon are probed again each session, since loose files and archives can add one without a plugin changing.
+	//
+	// The cache file is little-endian without padding:
+	//   u32 magic, u32 version, u64 fingerprint, u32 count
+	//   count entries, each as a u32 formID, u16 path length and the path bytes
+	class PerkIconCache
+	{
+	public:
+		static constexpr std::uint32_t MAGIC{ 'B' | ('K' << 8) | ('P' << 16) | ('I' << 24) };
+		static constexpr std::uint32_t VERSION{ 1 };
+
+		// Returns an empty path if the perk has no icon of its own
+		static std::string_view Get(const RE::BGSPerk* a_perk)
+		{
+			auto [iter, inserted] = icons.try_emplace(a_perk->formID);
+			if (inserted)
+			{
+				iter->second = Resolve(a_perk);
+				isDirty = isDirty || !iter->second.empty();
+			}
+
+			return iter->second;
+		}
+
+		// Only reads the file once per load of the game data, the cache outlives any one perk graph
+		static void Load()
+		{
+			if (std::exchange(isLoaded, true) || !*Settings::EnablePerkIconCache)
+			{
+				return;
+			}
+
+			std::ifstream file{ GetCachePath(), std::ios::binary };
+			if (!file)
+			{
+				return;
+			}
+
+			if (ReadValue<std::uint32_t>(file) != MAGIC || ReadValue<std::uint32_t>(file) != VERSION || ReadValue<std::uint64_t>(file) != GetFingerprint())
+			{
+				logger::debug("PerkIconCache: Icon cache is out of date."sv);
+				return;
+			}
+
+			auto count = ReadValue<std::uint32_t>(file);
+			decltype(icons) loaded;
+			loaded.reserve(count);
+			for (std::uint32_t i = 0; i < count && file; i++)
+			{
+				auto formID = ReadValue<std::uint32_t>(file);
+				std::string path(ReadValue<std::uint16_t>(file), '\0');
+				file.read(path.data(), path.size());
+				if (!path.empty())
+				{
+					loaded.insert_or_assign(formID, std::move(path));
+				}
+			}
+
+			if (!file)
+			{
+				logger::warn("PerkIconCache: Icon cache is truncated."sv);
+				return;
+			}
+
+			icons = std::move(loaded);
+			logger::debug(FMT_STRING("PerkIconCache: Loaded {:d} icon paths"), icons.size());
+		}
+
+		// FormIDs only name the same perks while the load order is unchanged, so nothing resolved before an unload is kept
+		static void Reset()
+		{
+			icons.clear();
+			isLoaded = false;
+			isDirty = false;
+		}
+
+		// Only writes when a perk was resolved that the file did not already know about
+		static void Save()
+		{
+			if (!std::exchange(isDirty, false) || !*Settings::EnablePerkIconCache)
+			{
+				return;
+			}
+
+			auto path = GetCachePath();
+			auto tempPath = path;
+			tempPath += ".tmp";
+
+			{
+				std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+				WriteValue(file, MAGIC);
+				WriteValue(file, VERSION);
+				WriteValue(file, GetFingerprint());
+				auto count = std::ranges::count_if(icons, [](const auto& a_entry) { return !a_entry.second.empty(); });
+				WriteValue(file, static_cast<std::uint32_t>(count));
+				for (auto& [formID, icon] : icons)
+				{
+					if (icon.empty())
+					{
+						continue;
+					}
+
+					WriteValue(file, formID);
+					WriteValue(file, static_cast<std::uint16_t>(icon.size()));
+					file.write(icon.data(), icon.size());
+				}
+
+				if (!file)
+				{
+					logger::warn("PerkIconCache: Failed to write icon cache."sv);
+					return;
+				}
+			}
+
+			std::error_code ec;
+			std::filesystem::rename(tempPath, path, ec);
+			if (ec)
+			{
+				logger::warn(FMT_STRING("PerkIconCache: Failed to replace icon cache: {:s}"), ec.message());
+				std::filesystem::remove(tempPath, ec);
+			}
+		}
+
+	private:
+		static std::string Resolve(const RE::BGSPerk* a_perk)
+		{
+			if (std::string_view swfFile{ a_perk->swfFile }; !swfFile.empty() && Exists(swfFile))
+			{
+				return std::string{ swfFile };
+			}
+
+			auto formattedPath = fmt::format(FMT_STRING("Components\\VaultBoys\\Perks\\PerkClip_{:x}.swf"), a_perk->formID);
+			if (Exists(formattedPath))
+			{
+				return formattedPath;
+			}
+
+			return {};
+		}
+
+		// Loose files are found from their metadata alone, a stream is only opened for paths that may be in an archive
+		static bool Exists(std::string_view a_path)
+		{
+			auto relativePath = fmt::format(FMT_STRING("Interface\\{:s}"), a_path);
+
+			std::error_code ec;
+			if (std::filesystem::is_regular_file(std::filesystem::path{ "Data" } / relativePath, ec))
+			{
+				return true;
+			}
+
+			RE::BSTSmartPointer<RE::BSResource::Stream> stream{ nullptr };
+			return (RE::BSResource::GetOrCreateStream(relativePath.c_str(), stream) == RE::BSResource::ErrorCode::kNone);
+		}
+
+		static std::filesystem::path GetCachePath()
+		{
+			return fmt::format(FMT_STRING("Data/F4SE/Plugins/{}_PerkIcons.cache"), Version::PROJECT);
+		}
+
+		// The load order decides which perk a formID names. A stored icon is trusted while it is unchanged,
+		// even if the loose file or archive that provided it was removed since.
+		static std::uint64_t GetFingerprint()
+		{
+			Utils::Fingerprint fingerprint;
+			fingerprint.Add(std::uint64_t{ VERSION });
+			fingerprint.AddLoadOrder(Utils::Fingerprint::Sources::Capture());
+			return fingerprint.Get();
+		}
+
+		template<class T>
+		static T ReadValue(std::ifstream& a_file)
+		{
+			T value{};
+			a_file.read(reinterpret_cast<char*>(std::addressof(value)), sizeof(value));
+			return value;
+		}
+
+		template<class T>
+		static void WriteValue(std::ofstream& a_file, T a_value)
+		{
+			a_file.write(reinterpret_cast<const char*>(std::addressof(a_value)), sizeof(a_value));
+		}
+
+		static inline std::unordered_map<std::uint32_t, std::string> icons;
+		static inline bool isLoaded{ false };
+		static inline bool isDirty{ false };
+	};
+}
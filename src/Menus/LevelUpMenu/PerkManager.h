@@ -1,18 +1,66 @@
 #pragma once
+#include "ConditionProgram.h"
 #include "Forms/Forms.h"
+#include "PerkGraph.h"
+#include "PerkIconCache.h"
+#include "TextArena.h"
 
 namespace Menus
 {
 	class PerkManager
 	{
 	public:
-		using PerkMap = std::map<std::uint32_t, RE::BGSPerk*>;
+		class DependencyIndex;
+		class LevelIndex;
 
+		// A value in the game that decides whether a condition holds, and so whether a rank is available
+		struct Dependency
+		{
+			enum class Type : std::uint32_t
+			{
+				kActorValue,
+				kBaseActorValue,
+				kPermanentActorValue,
+				kPerk,
+				kGlobal,
+				kCondition
+			};
+
+			// Conditions without a value of their own to watch, like sex, or that are not run on the player against a fixed number,
+			// are tracked through their result
+			float Read(RE::PlayerCharacter* a_player) const
+			{
+				switch (type)
+				{
+					case Type::kActorValue:
+						return a_player->GetActorValue(*static_cast<RE::ActorValueInfo*>(form));
+					case Type::kBaseActorValue:
+						return a_player->GetBaseActorValue(*static_cast<RE::ActorValueInfo*>(form));
+					case Type::kPermanentActorValue:
+						return a_player->GetPermanentActorValue(*static_cast<RE::ActorValueInfo*>(form));
+					case Type::kPerk:
+						return static_cast<float>(a_player->GetPerkRank(static_cast<RE::BGSPerk*>(form)));
+					case Type::kGlobal:
+						return static_cast<RE::TESGlobal*>(form)->value;
+					default:
+						return static_cast<RE::TESConditionItem*>(form)->IsTrue(a_player, nullptr) ? 1.0F : 0.0F;
+				}
+			}
+
+			auto operator<=>(const Dependency&) const = default;
+
+			Type type;
+			void* form;
+		};
+
+		// Text and validity only depend on the perk data, so they are resolved once. Whether a condition holds is checked per open.
 		class PerkCondition
 		{
 		public:
-			PerkCondition(RE::TESConditionItem* a_condition)
+			PerkCondition(RE::TESConditionItem* a_condition, TextArena& a_text) :
+				_condition(a_condition)
 			{
+				std::string conditionText;
 				RE::stl::enumeration functionID{ RE::SCRIPT_OUTPUT::START_OF_FUNCTION_SECTION, a_condition->data.functionData.function.get() };
 				switch (functionID.get())
 				{
@@ -27,62 +75,44 @@ namespace Menus
 								break;
 							}
 
-							auto compareValue = a_condition->GetComparisonValue();
-							switch (a_condition->data.condition)
+							switch (functionID.get())
 							{
-								case RE::ENUM_COMPARISON_CONDITION::kEqual:
-									_conditionText = fmt::format(
-										Forms::sBakaEqual.GetString(),
-										actorValue->GetFullName(),
-										compareValue);
-									break;
-								case RE::ENUM_COMPARISON_CONDITION::kNotEqual:
-									_conditionText = fmt::format(
-										Forms::sBakaNotEqual.GetString(),
-										actorValue->GetFullName(),
-										compareValue);
-									break;
-								case RE::ENUM_COMPARISON_CONDITION::kGreaterThan:
-									_conditionText = fmt::format(
-										Forms::sBakaGreater.GetString(),
-										actorValue->GetFullName(),
-										compareValue + 1.0F);
-									break;
-								case RE::ENUM_COMPARISON_CONDITION::kGreaterThanEqual:
-									_conditionText = fmt::format(
-										Forms::sBakaGreaterEqual.GetString(),
-										actorValue->GetFullName(),
-										compareValue);
+								case RE::SCRIPT_OUTPUT::FUNCTION_GET_BASE_ACTOR_VALUE:
+									_dependency = { Dependency::Type::kBaseActorValue, actorValue };
 									break;
-								case RE::ENUM_COMPARISON_CONDITION::kLessThan:
-									_conditionText = fmt::format(
-										Forms::sBakaLess.GetString(),
-										actorValue->GetFullName(),
-										compareValue);
-									break;
-								case RE::ENUM_COMPARISON_CONDITION::kLessThanEqual:
-									_conditionText = fmt::format(
-										Forms::sBakaLessEqual.GetString(),
-										actorValue->GetFullName(),
-										compareValue + 1.0F);
+								case RE::SCRIPT_OUTPUT::FUNCTION_GET_PERMANENT_ACTOR_VALUE:
+									_dependency = { Dependency::Type::kPermanentActorValue, actorValue };
 									break;
 								default:
-									_isValid = false;
+									_dependency = { Dependency::Type::kActorValue, actorValue };
 									break;
 							}
 
-							_isTrue = a_condition->IsTrue(RE::PlayerCharacter::GetSingleton(), nullptr);
+							conditionText = GetActorValueText(a_condition, actorValue);
+							if (conditionText.empty())
+							{
+								_isValid = false;
+							}
+
+							_hasComparandText = true;
+							_isChecked = true;
 							break;
 						}
 
 					case RE::SCRIPT_OUTPUT::FUNCTION_GET_IS_SEX:
 					case RE::SCRIPT_OUTPUT::FUNCTION_GET_GLOBAL_VALUE:
 						{
-							if (!a_condition->IsTrue(RE::PlayerCharacter::GetSingleton(), nullptr))
+							auto global = a_condition->data.functionData.param[0];
+							if (functionID.get() == RE::SCRIPT_OUTPUT::FUNCTION_GET_GLOBAL_VALUE && global)
 							{
-								_isValid = false;
+								_dependency = { Dependency::Type::kGlobal, global };
+							}
+							else
+							{
+								_dependency = { Dependency::Type::kCondition, a_condition };
 							}
 
+							_isChecked = true;
 							_isBlank = true;
 							break;
 						}
@@ -103,20 +133,22 @@ namespace Menus
 								break;
 							}
 
+							_dependency = { Dependency::Type::kPerk, perk };
+
 							switch (a_condition->data.condition)
 							{
 								case RE::ENUM_COMPARISON_CONDITION::kEqual:
-									_conditionText = fmt::format(Forms::sBakaHasPerk.GetString(), perk->GetFullName());
+									conditionText = fmt::format(Forms::sBakaHasPerk.GetString(), perk->GetFullName());
 									break;
 								case RE::ENUM_COMPARISON_CONDITION::kNotEqual:
-									_conditionText = fmt::format(Forms::sBakaNotPerk.GetString(), perk->GetFullName());
+									conditionText = fmt::format(Forms::sBakaNotPerk.GetString(), perk->GetFullName());
 									break;
 								default:
 									_isValid = false;
 									break;
 							}
 
-							_isTrue = a_condition->IsTrue(RE::PlayerCharacter::GetSingleton(), nullptr);
+							_isChecked = true;
 							break;
 						}
 
@@ -124,109 +156,275 @@ namespace Menus
 						break;
 				}
 
+				// Only comparisons of the player's own values against a fixed number compile to a comparison on the snapshot.
+				// Anything run on another reference, or compared against a global, is asked of the game as the menu always did.
+				if (_isChecked && IsAskedOfGame(a_condition))
+				{
+					_dependency = { Dependency::Type::kCondition, a_condition };
+				}
+
+				_hasComparandText = _hasComparandText && a_condition->data.valueIsGlobal;
 				_isOr = (a_condition->next && a_condition->data.compareOr);
+				_conditionText = a_text.Add(conditionText);
+				_errorText = a_text.Add(ErrorTag(conditionText));
+
+				if (_hasComparandText)
+				{
+					_comparand = a_condition->GetComparisonValue();
+					_comparandText = { std::string{ _conditionText }, std::string{ _errorText } };
+				}
+			}
+
+			// Conditions on functions the menu does not describe are not checked either, so they always hold
+			void Compile(ConditionProgram& a_program, const DependencyIndex& a_index);
+
+			bool IsTrue(const ConditionProgram::Results& a_results) const noexcept
+			{
+				return a_results.conditions[_instruction];
+			}
+
+			// Conditions that compare against a global are as they were when the perk data loaded
+			std::string_view GetConditionText(bool a_isTrue) const noexcept
+			{
+				return a_isTrue ? _conditionText : _errorText;
+			}
+
+			// Text with a global's value in it is built again when the global changes, not on every evaluation
+			void AppendConditionText(bool a_isTrue, std::string& a_text) const
+			{
+				if (!_hasComparandText)
+				{
+					a_text += GetConditionText(a_isTrue);
+					return;
+				}
+
+				if (auto comparand = _condition->GetComparisonValue(); comparand != _comparand)
+				{
+					auto text = GetActorValueText(_condition, static_cast<RE::ActorValueInfo*>(_condition->data.functionData.param[0]));
+					_comparand = comparand;
+					_comparandText = { text, ErrorTag(text) };
+				}
+
+				a_text += _comparandText[!a_isTrue];
+			}
+
+			// Conditions that are never checked have none
+			void GetDependencies(std::vector<Dependency>& a_dependencies) const
+			{
+				if (!_isChecked)
+				{
+					return;
+				}
+
+				a_dependencies.push_back(_dependency);
+
+				// The result alone would miss a change of the global that leaves it as it was, but not the text
+				if (_condition->data.valueIsGlobal && _condition->data.global)
+				{
+					a_dependencies.push_back({ Dependency::Type::kGlobal, _condition->data.global });
+				}
+			}
+
+			// Whether the condition is run on anything but the player, or compared against a global
+			static bool IsAskedOfGame(const RE::TESConditionItem* a_condition) noexcept
+			{
+				return a_condition->data.valueIsGlobal || a_condition->data.object != RE::CONDITIONITEMOBJECT::kSelf;
 			}
 
-			constexpr std::string_view GetConditionText() const noexcept { return { _conditionText.data(), _conditionText.size() }; }
 			constexpr bool IsOr() const noexcept { return _isOr; }
-			constexpr bool IsTrue() const noexcept { return _isTrue; }
 			constexpr bool IsBlank() const noexcept { return _isBlank; }
 			constexpr bool IsValid() const noexcept { return _isValid; }
 
 		private:
-			std::string _conditionText;
+			// Returns nothing for comparisons the menu does not describe
+			static std::string GetActorValueText(RE::TESConditionItem* a_condition, RE::ActorValueInfo* a_actorValue)
+			{
+				auto compareValue = a_condition->GetComparisonValue();
+				switch (a_condition->data.condition)
+				{
+					case RE::ENUM_COMPARISON_CONDITION::kEqual:
+						return fmt::format(
+							Forms::sBakaEqual.GetString(),
+							a_actorValue->GetFullName(),
+							compareValue);
+					case RE::ENUM_COMPARISON_CONDITION::kNotEqual:
+						return fmt::format(
+							Forms::sBakaNotEqual.GetString(),
+							a_actorValue->GetFullName(),
+							compareValue);
+					case RE::ENUM_COMPARISON_CONDITION::kGreaterThan:
+						return fmt::format(
+							Forms::sBakaGreater.GetString(),
+							a_actorValue->GetFullName(),
+							compareValue + 1.0F);
+					case RE::ENUM_COMPARISON_CONDITION::kGreaterThanEqual:
+						return fmt::format(
+							Forms::sBakaGreaterEqual.GetString(),
+							a_actorValue->GetFullName(),
+							compareValue);
+					case RE::ENUM_COMPARISON_CONDITION::kLessThan:
+						return fmt::format(
+							Forms::sBakaLess.GetString(),
+							a_actorValue->GetFullName(),
+							compareValue);
+					case RE::ENUM_COMPARISON_CONDITION::kLessThanEqual:
+						return fmt::format(
+							Forms::sBakaLessEqual.GetString(),
+							a_actorValue->GetFullName(),
+							compareValue + 1.0F);
+					default:
+						return {};
+				}
+			}
+
+			RE::TESConditionItem* _condition{ nullptr };
+			Dependency _dependency{};
+			std::uint32_t _instruction{ 0 };
+			std::string_view _conditionText;
+			std::string_view _errorText;
 			bool _isOr{ false };
-			bool _isTrue{ true };
+			bool _isChecked{ false };
 			bool _isValid{ true };
 			bool _isBlank{ false };
+			bool _hasComparandText{ false };
+			mutable float _comparand{ 0.0F };
+			mutable std::array<std::string, 2> _comparandText;
+		};
+
+		// Everything about a rank that depends on the player. The text is rebuilt in place, so once its capacity
+		// is reserved, re-evaluating a rank does not allocate.
+		struct RankState
+		{
+			std::string conditionText;
+			bool isValid{ true };
+			bool isTrue{ true };
 		};
 
 		class PerkConditions
 		{
 		public:
-			PerkConditions(RE::BGSPerk* a_perk)
+			PerkConditions(RE::BGSPerk* a_perk, TextArena& a_text)
 			{
 				if (auto condition = a_perk->perkConditions.head; condition)
 				{
 					do
 					{
-						PerkCondition newCondition{ condition };
+						PerkCondition newCondition{ condition, a_text };
 						if (!newCondition.IsValid())
 						{
 							_isValid = false;
+							_isEmpty = true;
+							_conditions.clear();
 							return;
 						}
 
-						if (!newCondition.IsTrue())
+						if (!newCondition.IsBlank())
 						{
-							_isAvailable = false;
+							_isEmpty = false;
 						}
 
-						_conditions.emplace_back(newCondition);
+						_conditions.emplace_back(std::move(newCondition));
 						condition = condition->next;
 					}
 					while (condition);
 				}
+			}
 
-				std::stringstream ss;
-				for (auto i = 0; i < _conditions.size();)
+			void Compile(ConditionProgram& a_program, const DependencyIndex& a_index)
+			{
+				_block = a_program.AddBlock();
+				for (auto& condition : _conditions)
 				{
-					auto condition = _conditions[i];
-					if (condition.IsBlank())
+					condition.Compile(a_program, a_index);
+				}
+			}
+
+			// Sex and global conditions are never listed, if one of them fails the rank is hidden rather than locked
+			bool IsValid(const ConditionProgram::Results& a_results) const
+			{
+				if (!_isValid)
+				{
+					return false;
+				}
+
+				return std::ranges::all_of(
+					_conditions,
+					[&](const PerkCondition& a_condition)
 					{
-						i++;
-						continue;
-					}
+						return !a_condition.IsBlank() || a_condition.IsTrue(a_results);
+					});
+			}
 
-					if (condition.IsTrue())
+			// The longest text Evaluate can append, with every listed condition unmet
+			std::size_t GetMaxTextLength() const noexcept
+			{
+				std::size_t result{ 0 };
+				for (auto& condition : _conditions)
+				{
+					if (!condition.IsBlank())
 					{
-						ss << condition.GetConditionText();
+						result += std::max(condition.GetConditionText(true).size(), condition.GetConditionText(false).size()) + " or "sv.size();
 					}
-					else
+				}
+
+				return result;
+			}
+
+			// Whether the conditions hold as a whole, with the engine's OR grouping
+			bool IsTrue(const ConditionProgram::Results& a_results) const noexcept
+			{
+				return a_results.blocks[_block];
+			}
+
+			// Appends the condition text for the player, with unmet conditions greyed out
+			void Evaluate(const ConditionProgram::Results& a_results, RankState& a_state) const
+			{
+				for (std::size_t i = 0; i < _conditions.size();)
+				{
+					auto& condition = _conditions[i];
+					if (condition.IsBlank())
 					{
-						ss << ErrorTag(condition.GetConditionText());
+						i++;
+						continue;
 					}
 
-					_isEmpty = false;
+					auto isTrue = condition.IsTrue(a_results);
+					condition.AppendConditionText(isTrue, a_state.conditionText);
 					if (++i != _conditions.size() && !_conditions[i].IsBlank())
 					{
-						if (condition.IsOr())
-						{
-							ss << " or ";
-						}
-						else
-						{
-							ss << ", ";
-						}
+						a_state.conditionText += condition.IsOr() ? " or "sv : ", "sv;
 					}
 				}
+			}
 
-				_conditionText = ss.str();
+			void GetDependencies(std::vector<Dependency>& a_dependencies) const
+			{
+				for (auto& condition : _conditions)
+				{
+					condition.GetDependencies(a_dependencies);
+				}
 			}
 
-			constexpr std::string_view GetConditionText() const noexcept { return { _conditionText.data(), _conditionText.size() }; }
 			constexpr bool IsEmpty() const noexcept { return _isEmpty; }
 			constexpr bool IsValid() const noexcept { return _isValid; }
-			constexpr bool IsAvailable() const noexcept { return _isAvailable; }
 
 		private:
 			std::vector<PerkCondition> _conditions;
-			std::string _conditionText;
+			std::uint32_t _block{ 0 };
 			bool _isEmpty{ true };
 			bool _isValid{ true };
-			bool _isAvailable{ true };
 		};
 
 		class PerkRank
 		{
 		public:
-			PerkRank(RE::BGSPerk* a_perk)
+			PerkRank(RE::BGSPerk* a_perk, TextArena& a_text) :
+				_conditions(a_perk, a_text)
 			{
 				_perk = a_perk;
-				_perk->GetDescription(_description);
-				_name = _perk->GetFullName();
+				_name = a_text.Add(_perk->GetFullName());
 
-				GetConditions();
+				GetConditions(a_text);
 			}
 
 			constexpr RE::BGSPerk* operator->() const
@@ -234,166 +432,191 @@ namespace Menus
 				return _perk;
 			}
 
-			constexpr std::string_view GetName() const noexcept { return { _name.data(), _name.size() }; }
-			constexpr std::string_view GetConditionText() const noexcept { return { _conditionText.data(), _conditionText.size() }; }
-			constexpr std::string_view GetDescription() const noexcept { return { _description.data(), _description.size() }; }
-			constexpr std::string_view GetPerkIcon() const noexcept { return { _perkIcon.data(), _perkIcon.size() }; }
+			// Every text of a rank is null terminated
+			constexpr std::string_view GetName() const noexcept { return _name; }
+			constexpr std::string_view GetPerkIcon() const noexcept { return _perkIcon; }
 			constexpr RE::BGSPerk* GetPerk() const noexcept { return _perk; }
-			constexpr bool IsValid() const noexcept { return _isValid; }
-			constexpr bool IsAvailable() const noexcept { return _isAvailable; }
+			constexpr bool IsValid() const noexcept { return _conditions.IsValid(); }
 			constexpr std::int8_t GetPerkLevel() const noexcept { return _perkLevel; }
 
-			void SetPerkIcon(std::string_view a_path) noexcept { _perkIcon = a_path; }
+			void SetPerkIcon(std::string_view a_path, TextArena& a_text) { _perkIcon = a_text.Add(a_path); }
 
-		private:
-			void GetConditions()
+			// The longest text Evaluate can build for this rank
+			std::size_t GetMaxTextLength() const noexcept
 			{
-				PerkConditions perkConditions{ _perk };
-				_isValid = perkConditions.IsValid();
-				_isAvailable = perkConditions.IsAvailable();
-				_perkLevel = std::max(_perk->data.level, static_cast<std::int8_t>(1));
+				return std::max(
+						   std::max(_reqsText[true].size(), _reqsText[false].size()) + _conditions.GetMaxTextLength(),
+						   std::max(_blankReqsText[true].size(), _blankReqsText[false].size())) +
+				       _tailText.size();
+			}
 
-				auto refrLevel = RE::PlayerCharacter::GetSingleton()->GetLevel();
+			void GetDependencies(std::vector<Dependency>& a_dependencies) const
+			{
+				a_dependencies.push_back({ Dependency::Type::kPerk, _perk });
+				_conditions.GetDependencies(a_dependencies);
+			}
 
-				std::string levelText = fmt::format(Forms::sBakaLevel.GetString(), _perkLevel);
-				std::string ranksText = fmt::format(Forms::sBakaRanks.GetString(), _perk->data.numRanks);
-				if (refrLevel < _perkLevel)
-				{
-					levelText = ErrorTag(levelText);
-					_isAvailable = false;
-				}
+			void Compile(ConditionProgram& a_program, const DependencyIndex& a_index)
+			{
+				_conditions.Compile(a_program, a_index);
+			}
 
-				if (perkConditions.IsEmpty())
-				{
-					if (_perkLevel < 3)
-					{
-						levelText = "--";
-					}
+			// Only the pieces of the text that depend on the player are filled in here
+			void Evaluate(std::uint16_t a_level, const ConditionProgram::Results& a_results, RankState& a_state) const
+			{
+				a_state.isValid = _conditions.IsValid(a_results);
+				a_state.isTrue = _conditions.IsTrue(a_results);
+
+				auto levelMet = a_level >= _perkLevel;
 
-					std::string reqsText = fmt::format(Forms::sBakaReqs.GetString(), levelText);
-					_conditionText = fmt::format(
-						FMT_STRING("{:s}<br>{:s}<br><br>{:s}"),
-						reqsText,
-						ranksText,
-						GetDescription());
+				// A hidden rank lists none of its conditions
+				if (a_state.isValid && !_conditions.IsEmpty())
+				{
+					a_state.conditionText.assign(_reqsText[levelMet]);
+					_conditions.Evaluate(a_results, a_state);
 				}
 				else
 				{
-					std::string reqsText = fmt::format(Forms::sBakaReqs.GetString(), levelText);
-					_conditionText = fmt::format(
-						FMT_STRING("{:s}, {:s}<br>{:s}<br><br>{:s}"),
-						reqsText,
-						perkConditions.GetConditionText(),
-						ranksText,
-						GetDescription());
+					a_state.conditionText.assign(_blankReqsText[levelMet]);
 				}
+
+				a_state.conditionText += _tailText;
 			}
 
-			std::string _name;
-			std::string _conditionText;
-			std::string _perkIcon;
-			RE::BSStringT<char> _description;
+		private:
+			void GetConditions(TextArena& a_text)
+			{
+				_perkLevel = std::max(_perk->data.level, static_cast<std::int8_t>(1));
+
+				std::string levelText = fmt::format(Forms::sBakaLevel.GetString(), _perkLevel);
+				std::string levelErrorText = ErrorTag(levelText);
+				_reqsText[true] = a_text.Add(fmt::format(FMT_STRING("{:s}, "), fmt::format(Forms::sBakaReqs.GetString(), levelText)));
+				_reqsText[false] = a_text.Add(fmt::format(FMT_STRING("{:s}, "), fmt::format(Forms::sBakaReqs.GetString(), levelErrorText)));
+
+				if (_perkLevel < 3)
+				{
+					levelText = "--";
+					levelErrorText = "--";
+				}
+
+				_blankReqsText[true] = a_text.Add(fmt::format(Forms::sBakaReqs.GetString(), levelText));
+				_blankReqsText[false] = a_text.Add(fmt::format(Forms::sBakaReqs.GetString(), levelErrorText));
+
+				RE::BSStringT<char> description;
+				_perk->GetDescription(description);
+				_tailText = a_text.Add(fmt::format(
+					FMT_STRING("<br>{:s}<br><br>{:s}"),
+					fmt::format(Forms::sBakaRanks.GetString(), _perk->data.numRanks),
+					std::string_view{ description.data(), description.size() }));
+			}
+
+			PerkConditions _conditions;
+			std::string_view _name;
+			std::array<std::string_view, 2> _reqsText;
+			std::array<std::string_view, 2> _blankReqsText;
+			std::string_view _tailText;
+			std::string_view _perkIcon;
 			RE::BGSPerk* _perk{ nullptr };
-			bool _isValid;
-			bool _isAvailable;
 			std::int8_t _perkLevel;
 		};
 
 		class PerkChain
 		{
 		public:
-			PerkChain(RE::BGSPerk* a_perk)
+			// Takes the ranks as PerkGraph resolved them
+			PerkChain(std::span<RE::BGSPerk* const> a_ranks, TextArena& a_text)
 			{
-				if (!a_perk->nextPerk && a_perk->data.numRanks > 1)
+				_perkChain.reserve(a_ranks.size());
+				for (auto perk : a_ranks)
 				{
-					for (auto i = 0; i < a_perk->data.numRanks; i++)
-					{
-						Add(a_perk);
-					}
+					_perkChain.emplace_back(perk, a_text);
 				}
-				else
+
+				SetPerkIcons(a_text);
+			}
+
+			std::span<const PerkRank> Get() const noexcept
+			{
+				return _perkChain;
+			}
+
+			// Takes one state per rank
+			void Evaluate(std::uint16_t a_level, const ConditionProgram::Results& a_results, std::span<RankState> a_states) const
+			{
+				for (std::size_t i = 0; i < _perkChain.size(); i++)
 				{
-					do
-					{
-						Add(a_perk);
-						a_perk = a_perk->nextPerk;
-					}
-					while (a_perk && a_perk != _perkChain[0].GetPerk());
+					_perkChain[i].Evaluate(a_level, a_results, a_states[i]);
 				}
+			}
 
-				SetPerkIcons();
+			void Compile(ConditionProgram& a_program, const DependencyIndex& a_index)
+			{
+				for (auto& rank : _perkChain)
+				{
+					rank.Compile(a_program, a_index);
+				}
 			}
 
-			std::vector<PerkRank> Get()
+			// Every value on the player that Evaluate and GetFirstAvailableRank read, besides the player's level
+			std::vector<Dependency> GetDependencies() const
 			{
-				return _perkChain;
+				std::vector<Dependency> result;
+				for (auto& rank : _perkChain)
+				{
+					rank.GetDependencies(result);
+				}
+
+				std::ranges::sort(result);
+				auto duplicates = std::ranges::unique(result);
+				result.erase(duplicates.begin(), duplicates.end());
+				return result;
 			}
 
-			std::pair<PerkRank, std::int8_t> GetFirstAvailableRank()
+			// Returns -1 if the player has every rank, or a rank before the next one cannot be shown
+			std::int8_t GetFirstAvailableRank(RE::PlayerCharacter* a_player, std::span<const RankState> a_states) const
 			{
 				for (std::int8_t i = 0; i < _perkChain.size(); i++)
 				{
-					auto curPerk = _perkChain[i];
-					auto curRank = RE::PlayerCharacter::GetSingleton()
-									   ->GetPerkRank(curPerk.GetPerk());
+					auto& curPerk = _perkChain[i];
+					auto curRank = a_player->GetPerkRank(curPerk.GetPerk());
 
-					if (!curPerk.IsValid())
+					if (!a_states[i].isValid)
 					{
-						return { _perkChain[0], static_cast<std::int8_t>(-1) };
+						return -1;
 					}
 
 					if (curRank == 0)
 					{
-						return { curPerk, i };
+						return i;
 					}
 
 					if (!curPerk->nextPerk && curPerk->data.numRanks > curRank)
 					{
-						return { curPerk, i };
+						return i;
 					}
 				}
 
-				return { _perkChain[0], static_cast<std::int8_t>(-1) };
+				return -1;
 			}
 
 		private:
-			void Add(RE::BGSPerk* a_perk)
-			{
-				PerkRank rank{ a_perk };
-				_perkChain.emplace_back(rank);
-			}
-
-			void SetPerkIcons()
+			void SetPerkIcons(TextArena& a_text)
 			{
-				auto IsValidPath = [](auto a_path)
-				{
-					RE::BSTSmartPointer<RE::BSResource::Stream> stream{ nullptr };
-					auto relativePath = fmt::format(FMT_STRING("Interface\\{:s}"), a_path);
-					return (RE::BSResource::GetOrCreateStream(relativePath.c_str(), stream) == RE::BSResource::ErrorCode::kNone);
-				};
-
 				for (auto i = 0; i < _perkChain.size(); i++)
 				{
-					if (IsValidPath(_perkChain[i]->swfFile))
-					{
-						_perkChain[i].SetPerkIcon(_perkChain[i]->swfFile);
-						continue;
-					}
-
-					auto formattedPath = fmt::format(FMT_STRING("Components\\VaultBoys\\Perks\\PerkClip_{:x}.swf"), _perkChain[i]->formID);
-					if (IsValidPath(formattedPath))
+					if (auto icon = PerkIconCache::Get(_perkChain[i].GetPerk()); !icon.empty())
 					{
-						_perkChain[i].SetPerkIcon(formattedPath);
+						_perkChain[i].SetPerkIcon(icon, a_text);
 						continue;
 					}
 
 					if (i != 0)
 					{
-						_perkChain[i].SetPerkIcon(_perkChain[0].GetPerkIcon());
+						_perkChain[i].SetPerkIcon(_perkChain[0].GetPerkIcon(), a_text);
 						continue;
 					}
 
-					_perkChain[i].SetPerkIcon("Components\\Quest Vault Boys\\Miscellaneous Quests\\DefaultBoy.swf"sv);
+					_perkChain[i].SetPerkIcon("Components\\Quest Vault Boys\\Miscellaneous Quests\\DefaultBoy.swf"sv, a_text);
 				}
 			}
 
@@ -404,101 +627,507 @@ namespace Menus
 			public std::vector<PerkChain>
 		{
 		public:
-			void AddChain(RE::BGSPerk* a_perk, PerkMap& a_perkMap)
+			void AddChain(std::span<RE::BGSPerk* const> a_ranks, TextArena& a_text)
 			{
-				PerkChain chain{ a_perk };
-				for (auto& perk : chain.Get())
-				{
-					a_perkMap.insert_or_assign(perk->formID, nullptr);
-				}
-
-				emplace_back(chain);
+				emplace_back(a_ranks, a_text);
 			}
 		};
 
-		PerkManager()
+		// Maps each value on the player to the perk chains that read it
+		class DependencyIndex
 		{
-			auto TESDataHandler = RE::TESDataHandler::GetSingleton();
-			if (!TESDataHandler)
+		public:
+			void Build(const PerkChainList& a_chains)
 			{
-				return;
+				std::vector<std::pair<Dependency, std::uint32_t>> edges;
+				for (std::uint32_t i = 0; i < a_chains.size(); i++)
+				{
+					for (auto& dependency : a_chains[i].GetDependencies())
+					{
+						edges.emplace_back(GetShared(dependency), i);
+					}
+				}
+
+				std::ranges::sort(edges);
+				for (auto& [dependency, chain] : edges)
+				{
+					if (_dependencies.empty() || _dependencies.back() != dependency)
+					{
+						_dependencies.push_back(dependency);
+						_offsets.push_back(static_cast<std::uint32_t>(_chains.size()));
+					}
+
+					_chains.push_back(chain);
+				}
+
+				_offsets.push_back(static_cast<std::uint32_t>(_chains.size()));
 			}
 
-			PerkMap perkMap;
-			for (auto perk : TESDataHandler->GetFormArray<RE::BGSPerk>())
+			std::span<const Dependency> GetDependencies() const noexcept { return _dependencies; }
+
+			// Where the value of a dependency read by one of the indexed chains sits in a snapshot
+			std::uint32_t GetSlot(Dependency a_dependency) const
 			{
-				if (perk->data.hidden || !perk->data.playable)
+				if (auto condition = static_cast<RE::TESConditionItem*>(a_dependency.form); a_dependency.type == Dependency::Type::kCondition && IsShared(condition))
 				{
-					continue;
+					a_dependency.form = _sharedConditions.at(GetKey(condition));
 				}
 
-				std::string_view name{ perk->GetFullName() };
-				if (name.empty())
+				auto iter = std::ranges::lower_bound(_dependencies, a_dependency);
+				assert(iter != _dependencies.end() && *iter == a_dependency);
+				return static_cast<std::uint32_t>(iter - _dependencies.begin());
+			}
+
+			std::span<const std::uint32_t> GetChains(std::size_t a_dependency) const noexcept
+			{
+				return { _chains.data() + _offsets[a_dependency], _chains.data() + _offsets[a_dependency + 1] };
+			}
+
+		private:
+			using ConditionKey = std::tuple<std::uint32_t, void*, void*, std::uint32_t, float>;
+			using SharedConditions = std::map<ConditionKey, RE::TESConditionItem*>;
+
+			static ConditionKey GetKey(RE::TESConditionItem* a_condition)
+			{
+				return {
+					static_cast<std::uint32_t>(a_condition->data.functionData.function.get()),
+					a_condition->data.functionData.param[0],
+					a_condition->data.functionData.param[1],
+					static_cast<std::uint32_t>(a_condition->data.condition),
+					a_condition->GetComparisonValue()
+				};
+			}
+
+			// The key only describes conditions run on the player against a fixed number
+			static bool IsShared(const RE::TESConditionItem* a_condition) noexcept
+			{
+				return !PerkCondition::IsAskedOfGame(a_condition);
+			}
+
+			// Conditions tracked through their result are read once for every condition that would give the same result
+			Dependency GetShared(Dependency a_dependency)
+			{
+				if (auto condition = static_cast<RE::TESConditionItem*>(a_dependency.form); a_dependency.type == Dependency::Type::kCondition && IsShared(condition))
 				{
-					continue;
+					a_dependency.form = _sharedConditions.try_emplace(GetKey(condition), condition).first->second;
 				}
 
-				perkMap.insert_or_assign(perk->formID, perk);
+				return a_dependency;
 			}
 
-			for (auto& [formID, perk] : perkMap)
+			std::vector<Dependency> _dependencies;
+			std::vector<std::uint32_t> _offsets;
+			std::vector<std::uint32_t> _chains;
+			SharedConditions _sharedConditions;
+		};
+
+		// Every rank of every perk chain bucketed by the player level it requires. Ranks are numbered chain by chain in list order,
+		// and for each required level a prefix bitset holds the ranks that level alone allows, so which ranks are available is
+		// that bitset ANDed with which ranks' conditions hold.
+		class LevelIndex
+		{
+		public:
+			using Bits = std::span<const std::uint64_t>;
+
+			void Build(const PerkChainList& a_chains)
 			{
-				auto firstPerk = GetFirstPerkInChain(perk);
-				if (!firstPerk)
+				std::vector<std::pair<std::uint16_t, std::uint32_t>> ranks;
+				_chainOffsets.assign(1, 0);
+				for (std::uint32_t i = 0; i < a_chains.size(); i++)
 				{
-					continue;
+					for (auto& rank : a_chains[i].Get())
+					{
+						ranks.emplace_back(static_cast<std::uint16_t>(rank.GetPerkLevel()), static_cast<std::uint32_t>(_chains.size()));
+						_chains.push_back(i);
+					}
+
+					_chainOffsets.push_back(static_cast<std::uint32_t>(_chains.size()));
+				}
+
+				std::ranges::sort(ranks);
+				for (auto& [level, rank] : ranks)
+				{
+					if (_levels.empty() || _levels.back() != level)
+					{
+						_levels.push_back(level);
+						_offsets.push_back(static_cast<std::uint32_t>(_ranks.size()));
+					}
+
+					_ranks.push_back(rank);
+				}
+
+				_offsets.push_back(static_cast<std::uint32_t>(_ranks.size()));
+
+				// The first bitset is for levels below every requirement, and is empty
+				_wordCount = (_ranks.size() + 63) / 64;
+				_bits.assign((_levels.size() + 1) * _wordCount, 0);
+				for (std::size_t i = 0; i < _levels.size(); i++)
+				{
+					auto bits = _bits.data() + (i + 1) * _wordCount;
+					std::copy_n(bits - _wordCount, _wordCount, bits);
+					for (auto j = _offsets[i]; j < _offsets[i + 1]; j++)
+					{
+						bits[_ranks[j] / 64] |= std::uint64_t{ 1 } << (_ranks[j] % 64);
+					}
 				}
+			}
+
+			[[nodiscard]] std::size_t GetRankCount() const noexcept { return _chains.size(); }
+			[[nodiscard]] std::size_t GetWordCount() const noexcept { return _wordCount; }
+
+			std::uint32_t GetRank(std::size_t a_chain, std::size_t a_rank) const noexcept { return _chainOffsets[a_chain] + static_cast<std::uint32_t>(a_rank); }
+			std::uint32_t GetChain(std::uint32_t a_rank) const noexcept { return _chains[a_rank]; }
+
+			// The ranks of a chain are numbered from here
+			std::uint32_t GetFirstRank(std::size_t a_chain) const noexcept { return _chainOffsets[a_chain]; }
+
+			// Which ranks a player of this level meets the level requirement of
+			Bits GetEligible(std::uint16_t a_level) const noexcept
+			{
+				auto level = std::ranges::upper_bound(_levels, a_level) - _levels.begin();
+				return { _bits.data() + level * _wordCount, _wordCount };
+			}
+
+			// The ranks that require a level above a_low, up to and including a_high, from the lowest requirement up
+			std::span<const std::uint32_t> GetUnlocks(std::uint16_t a_low, std::uint16_t a_high) const noexcept
+			{
+				auto begin = _offsets[std::ranges::upper_bound(_levels, a_low) - _levels.begin()];
+				auto end = _offsets[std::ranges::upper_bound(_levels, a_high) - _levels.begin()];
+				return { _ranks.data() + begin, _ranks.data() + std::max(begin, end) };
+			}
 
-				if (perk->data.trait)
+		private:
+			std::vector<std::uint16_t> _levels;
+			std::vector<std::uint32_t> _offsets;
+			std::vector<std::uint32_t> _ranks;
+			std::vector<std::uint32_t> _chains;
+			std::vector<std::uint32_t> _chainOffsets;
+			std::vector<std::uint64_t> _bits;
+			std::size_t _wordCount{ 0 };
+		};
+
+		// The perk list as the player last saw it. Update reads every value the list depends on into a snapshot,
+		// runs the condition program over it, and only rebuilds the chains that read a value which changed since the last update.
+		class PerkListState
+		{
+		public:
+			// Returns the number of chains that were re-evaluated
+			std::size_t Update(const PerkManager& a_manager, RE::PlayerCharacter* a_player)
+			{
+				auto& chains = a_manager.GetPerkChains();
+				auto& index = a_manager.GetDependencyIndex();
+				auto& levelIndex = a_manager.GetLevelIndex();
+				auto dependencies = index.GetDependencies();
+				auto level = a_player->GetLevel();
+
+				if (_generation != a_manager.GetGeneration())
 				{
-					m_TraitChains.AddChain(firstPerk, perkMap);
+					_generation = a_manager.GetGeneration();
+					_states.clear();
+					_states.reserve(levelIndex.GetRankCount());
+					_offsets.assign(1, 0);
+					for (auto& chain : chains)
+					{
+						for (auto& rank : chain.Get())
+						{
+							_states.emplace_back().conditionText.reserve(rank.GetMaxTextLength());
+						}
+
+						_offsets.push_back(static_cast<std::uint32_t>(_states.size()));
+					}
+
+					_rankIndices.assign(chains.size(), -1);
+					_isDirty.assign(chains.size(), true);
+					_isTrue.assign(levelIndex.GetWordCount(), 0);
+					_isAvailable.assign(levelIndex.GetWordCount(), 0);
+					_values.resize(dependencies.size());
+					for (std::size_t i = 0; i < dependencies.size(); i++)
+					{
+						_values[i] = dependencies[i].Read(a_player);
+					}
 				}
 				else
 				{
-					m_PerkChains.AddChain(firstPerk, perkMap);
+					for (std::size_t i = 0; i < dependencies.size(); i++)
+					{
+						if (auto value = dependencies[i].Read(a_player); value != _values[i])
+						{
+							_values[i] = value;
+							for (auto chain : index.GetChains(i))
+							{
+								_isDirty[chain] = true;
+							}
+						}
+					}
+
+					// Only the ranks whose level requirement the change crosses show different text
+					if (level != _level)
+					{
+						auto [low, high] = std::minmax(level, _level);
+						for (auto rank : levelIndex.GetUnlocks(low, high))
+						{
+							_isDirty[levelIndex.GetChain(rank)] = true;
+						}
+					}
+				}
+
+				_level = level;
+				a_manager.GetProgram().Run(_values, _results);
+
+				std::size_t count{ 0 };
+				for (std::size_t i = 0; i < chains.size(); i++)
+				{
+					if (_isDirty[i])
+					{
+						std::span<RankState> states{ _states.data() + _offsets[i], _states.data() + _offsets[i + 1] };
+						chains[i].Evaluate(level, _results, states);
+						_rankIndices[i] = chains[i].GetFirstAvailableRank(a_player, states);
+						_isDirty[i] = false;
+						count++;
+
+						// Ranks are numbered the same way here and in LevelIndex
+						for (auto rank = _offsets[i]; rank < _offsets[i + 1]; rank++)
+						{
+							auto bit = std::uint64_t{ 1 } << (rank % 64);
+							_isTrue[rank / 64] = _states[rank].isTrue ? (_isTrue[rank / 64] | bit) : (_isTrue[rank / 64] & ~bit);
+						}
+					}
+				}
+
+				auto eligible = levelIndex.GetEligible(level);
+				for (std::size_t i = 0; i < _isAvailable.size(); i++)
+				{
+					_isAvailable[i] = eligible[i] & _isTrue[i];
 				}
+
+				return count;
+			}
+
+			std::span<const RankState> GetStates(std::size_t a_chain) const noexcept
+			{
+				return { _states.data() + _offsets[a_chain], _states.data() + _offsets[a_chain + 1] };
 			}
+
+			std::int8_t GetRankIndex(std::size_t a_chain) const noexcept { return _rankIndices[a_chain]; }
+
+			// Takes a rank as numbered by LevelIndex
+			const RankState& GetState(std::uint32_t a_rank) const noexcept { return _states[a_rank]; }
+
+			// Whether the player can take the rank now, with both its level and its conditions met
+			bool IsAvailable(std::uint32_t a_rank) const noexcept
+			{
+				return (_isAvailable[a_rank / 64] >> (a_rank % 64)) & 1;
+			}
+
+		private:
+			std::vector<RankState> _states;
+			std::vector<std::uint32_t> _offsets;
+			std::vector<std::int8_t> _rankIndices;
+			std::vector<std::uint64_t> _isTrue;
+			std::vector<std::uint64_t> _isAvailable;
+			std::vector<float> _values;
+			ConditionProgram::Results _results;
+			std::vector<bool> _isDirty;
+			std::uint32_t _generation{ 0 };
+			std::uint16_t _level{ 0 };
+		};
+
+		// Perk data does not change after it is loaded, so the graph is built once and shared by every menu open
+		static void Initialize()
+		{
+			auto start = std::chrono::steady_clock::now();
+			PerkIconCache::Load();
+			instance.reset(new PerkManager());
+			instance->Compile();
+			instance->m_Generation = ++generation;
+			PerkIconCache::Save();
+
+			std::size_t rankCount{ 0 };
+			for (auto& chain : instance->m_PerkChains)
+			{
+				rankCount += chain.Get().size();
+			}
+
+			auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+			logger::debug(
+				FMT_STRING("PerkManager: Built {:d} perk chains ({:d} ranks, {:d} dependencies, {:d} instructions) and {:d} trait chains, {:d} strings, {:d} malformed links, in {:d}us"),
+				instance->m_PerkChains.size(),
+				rankCount,
+				instance->m_DependencyIndex.GetDependencies().size(),
+				instance->m_Program.size(),
+				instance->m_TraitChains.size(),
+				instance->m_Text.size(),
+				instance->m_MalformedCount,
+				elapsed.count());
+		}
+
+		static void Reset()
+		{
+			instance.reset();
+			PerkIconCache::Reset();
+		}
+
+		static const PerkManager* GetSingleton() noexcept
+		{
+			return instance.get();
 		}
 
-		PerkChainList GetPerkChains() const noexcept
+		const PerkChainList& GetPerkChains() const noexcept
 		{
 			return m_PerkChains;
 		}
 
-		PerkChainList GetTraitChains() const noexcept
+		const PerkChainList& GetTraitChains() const noexcept
 		{
 			return m_TraitChains;
 		}
 
-	private:
-		static std::string ErrorTag(std::string_view a_string)
+		const DependencyIndex& GetDependencyIndex() const noexcept
 		{
-			return fmt::format(FMT_STRING("<font color=\'#888888\'>{:s}</font>"), a_string);
+			return m_DependencyIndex;
+		}
+
+		const LevelIndex& GetLevelIndex() const noexcept
+		{
+			return m_LevelIndex;
+		}
+
+		const ConditionProgram& GetProgram() const noexcept
+		{
+			return m_Program;
 		}
 
-		RE::BGSPerk* GetFirstPerkInChain(RE::BGSPerk* a_perk)
+		// Changes every time the graph is rebuilt, so state kept against an older graph can be thrown away
+		std::uint32_t GetGeneration() const noexcept
 		{
-			if (!a_perk)
+			return m_Generation;
+		}
+
+	private:
+		PerkManager()
+		{
+			auto TESDataHandler = RE::TESDataHandler::GetSingleton();
+			if (!TESDataHandler)
+			{
+				return;
+			}
+
+			std::vector<RE::BGSPerk*> perks;
+			for (auto perk : TESDataHandler->GetFormArray<RE::BGSPerk>())
 			{
-				return nullptr;
+				if (perk->data.hidden || !perk->data.playable)
+				{
+					continue;
+				}
+
+				std::string_view name{ perk->GetFullName() };
+				if (name.empty())
+				{
+					continue;
+				}
+
+				perks.push_back(perk);
 			}
 
-			auto basePerk = a_perk;
-			auto nextPerk = a_perk->nextPerk;
-			for (auto i = 0; nextPerk && i < a_perk->data.numRanks; i++)
+			PerkGraph graph;
+			graph.Build(std::move(perks));
+			m_MalformedCount = graph.GetMalformedCount();
+
+			for (std::size_t i = 0; i < graph.size(); i++)
 			{
-				if (basePerk->data.level > nextPerk->data.level)
+				auto ranks = graph[i];
+				if (ranks[0]->data.trait)
 				{
-					basePerk = nextPerk;
+					m_TraitChains.AddChain(ranks, m_Text);
 				}
+				else
+				{
+					m_PerkChains.AddChain(ranks, m_Text);
+				}
+			}
+		}
 
-				nextPerk = nextPerk->nextPerk;
+		// Trait chains are never listed, so only perk chains are compiled
+		void Compile()
+		{
+			m_DependencyIndex.Build(m_PerkChains);
+			m_LevelIndex.Build(m_PerkChains);
+			for (auto& chain : m_PerkChains)
+			{
+				chain.Compile(m_Program, m_DependencyIndex);
 			}
+		}
 
-			return basePerk;
+		static std::string ErrorTag(std::string_view a_string)
+		{
+			return fmt::format(FMT_STRING("<font color=\'#888888\'>{:s}</font>"), a_string);
 		}
 
+		TextArena m_Text;
 		PerkChainList m_PerkChains;
 		PerkChainList m_TraitChains;
+		DependencyIndex m_DependencyIndex;
+		LevelIndex m_LevelIndex;
+		ConditionProgram m_Program;
+		std::size_t m_MalformedCount{ 0 };
+		std::uint32_t m_Generation{ 0 };
+
+		static inline std::unique_ptr<PerkManager> instance;
+		static inline std::uint32_t generation{ 0 };
 	};
+
+	inline void PerkManager::PerkCondition::Compile(ConditionProgram& a_program, const DependencyIndex& a_index)
+	{
+		using Op = ConditionProgram::Op;
+
+		if (!_isChecked)
+		{
+			_instruction = a_program.Add(0, Op::kTrue, 0.0F, _isOr);
+			return;
+		}
+
+		auto slot = a_index.GetSlot(_dependency);
+		switch (_dependency.type)
+		{
+			// The snapshot holds the perk's rank, HasPerk only asks whether there is one
+			case Dependency::Type::kPerk:
+				{
+					auto hasPerk = (_condition->data.condition == RE::ENUM_COMPARISON_CONDITION::kEqual);
+					_instruction = a_program.Add(slot, hasPerk ? Op::kGreater : Op::kLessEqual, 0.0F, _isOr);
+					break;
+				}
+
+			case Dependency::Type::kCondition:
+				_instruction = a_program.Add(slot, Op::kEqual, 1.0F, _isOr);
+				break;
+
+			default:
+				{
+					auto op = Op::kLessEqual;
+					switch (_condition->data.condition)
+					{
+						case RE::ENUM_COMPARISON_CONDITION::kEqual:
+							op = Op::kEqual;
+							break;
+						case RE::ENUM_COMPARISON_CONDITION::kNotEqual:
+							op = Op::kNotEqual;
+							break;
+						case RE::ENUM_COMPARISON_CONDITION::kGreaterThan:
+							op = Op::kGreater;
+							break;
+						case RE::ENUM_COMPARISON_CONDITION::kGreaterThanEqual:
+							op = Op::kGreaterEqual;
+							break;
+						case RE::ENUM_COMPARISON_CONDITION::kLessThan:
+							op = Op::kLess;
+							break;
+						default:
+							break;
+					}
+
+					_instruction = a_program.Add(slot, op, _condition->GetComparisonValue(), _isOr);
+					break;
+				}
+		}
+	}
 }
@@ -0,0 +1,51 @@
+#pragma once
+
+namespace Menus
+{
+	// Append-only storage for text built once and read for as long as its owner lives. Strings are null terminated
+	// and never move, so the views handed out stay valid and can be passed to Scaleform as they are.
+	// Equal strings are stored once.
+	class TextArena
+	{
+	public:
+		TextArena() = default;
+		TextArena(const TextArena&) = delete;
+		TextArena(TextArena&&) = default;
+
+		TextArena& operator=(const TextArena&) = delete;
+		TextArena& operator=(TextArena&&) = default;
+
+		std::string_view Add(std::string_view a_string)
+		{
+			if (auto iter = _strings.find(a_string); iter != _strings.end())
+			{
+				return *iter;
+			}
+
+			auto size = a_string.size() + 1;
+			if (_blocks.empty() || _used + size > _capacity)
+			{
+				_capacity = std::max(BLOCK_SIZE, size);
+				_blocks.emplace_back(std::make_unique<char[]>(_capacity));
+				_used = 0;
+			}
+
+			auto data = _blocks.back().get() + _used;
+			std::ranges::copy(a_string, data);
+			data[a_string.size()] = '\0';
+			_used += size;
+
+			return *_strings.emplace(data, a_string.size()).first;
+		}
+
+		[[nodiscard]] std::size_t size() const noexcept { return _strings.size(); }
+
+	private:
+		static constexpr std::size_t BLOCK_SIZE{ 64 * 1024 };
+
+		std::vector<std::unique_ptr<char[]>> _blocks;
+		std::unordered_set<std::string_view> _strings;
+		std::size_t _used{ 0 };
+		std::size_t _capacity{ 0 };
+	};
+}
@@ -0,0 +1,678 @@
+#pragma once
+#include "FormRegistry.h"
+
+namespace Menus
+{
+	class FormIndex
+	{
+	public:
+		static constexpr auto CATEGORY_COUNT = stl::to_underlying(FormCategory::kTotal);
+		static constexpr auto CATEGORY_NAMES = FormRegistry::KEYS;
+		static constexpr auto STAT_COUNT = stl::to_underlying(FormStat::kTotal);
+		static constexpr std::array<std::string_view, STAT_COUNT> STAT_NAMES{ "Value"sv, "Weight"sv, "Rating"sv };
+
+		static constexpr std::uint32_t MAGIC{ 'B' | ('K' << 8) | ('E' << 16) | ('I' << 24) };
+		static constexpr std::uint32_t VERSION{ 8 };
+
+		struct Range
+		{
+			std::uint32_t begin;
+			std::uint32_t end;
+		};
+
+		using RangeList = std::array<Range, CATEGORY_COUNT>;
+
+		// The index is a single position-independent image, so it can be written to and mapped from disk as-is
+		struct Header
+		{
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint64_t fingerprint;
+			std::uint32_t pluginCount;
+			std::uint32_t categoryCount;
+			std::array<std::uint32_t, CATEGORY_COUNT> columnSizes;
+			std::uint64_t nameBytes;
+			std::uint64_t overrideCount;
+		};
+
+		class FormList
+		{
+		public:
+			using value_type = std::pair<std::uint32_t, std::string_view>;
+			using StatColumns = std::array<const float*, STAT_COUNT>;
+
+			class iterator
+			{
+			public:
+				using iterator_category = std::forward_iterator_tag;
+				using difference_type = std::ptrdiff_t;
+				using value_type = FormList::value_type;
+				using pointer = void;
+				using reference = value_type;
+
+				iterator() = default;
+				iterator(const std::uint32_t* a_formID, const std::uint32_t* a_nameOffset, const char* a_names) :
+					formID(a_formID),
+					nameOffset(a_nameOffset),
+					names(a_names)
+				{}
+
+				[[nodiscard]] reference operator*() const noexcept { return { *formID, names + *nameOffset }; }
+
+				iterator& operator++() noexcept
+				{
+					++formID;
+					++nameOffset;
+					return *this;
+				}
+
+				iterator operator++(int) noexcept
+				{
+					auto tmp = *this;
+					++*this;
+					return tmp;
+				}
+
+				[[nodiscard]] bool operator==(const iterator& a_rhs) const noexcept { return formID == a_rhs.formID; }
+
+			private:
+				const std::uint32_t* formID{ nullptr };
+				const std::uint32_t* nameOffset{ nullptr };
+				const char* names{ nullptr };
+			};
+
+			FormList() = default;
+			FormList(const std::uint32_t* a_formIDs, const std::uint32_t* a_nameOffsets, const std::uint32_t* a_overrideOffsets, const StatColumns& a_stats, const char* a_names, const std::uint32_t* a_overrides, std::uint32_t a_size) :
+				formIDs(a_formIDs),
+				nameOffsets(a_nameOffsets),
+				overrideOffsets(a_overrideOffsets),
+				stats(a_stats),
+				names(a_names),
+				overrides(a_overrides),
+				count(a_size)
+			{}
+
+			[[nodiscard]] value_type operator[](std::uint32_t a_pos) const noexcept { return { formIDs[a_pos], names + nameOffsets[a_pos] }; }
+
+			[[nodiscard]] iterator begin() const noexcept { return { formIDs, nameOffsets, names }; }
+			[[nodiscard]] iterator end() const noexcept { return { formIDs + count, nameOffsets + count, names }; }
+			[[nodiscard]] std::uint32_t size() const noexcept { return count; }
+			[[nodiscard]] bool empty() const noexcept { return count == 0; }
+
+			// Plugins overriding the form after the one it originates from, in load order, so the last one wins
+			[[nodiscard]] std::span<const std::uint32_t> overrides_of(std::uint32_t a_pos) const noexcept
+			{
+				return { overrides + overrideOffsets[a_pos], overrides + overrideOffsets[a_pos + 1] };
+			}
+
+			[[nodiscard]] std::span<const float> stats_of(FormStat a_stat) const noexcept
+			{
+				return { stats[stl::to_underlying(a_stat)], count };
+			}
+
+			[[nodiscard]] float stat(FormStat a_stat, std::uint32_t a_pos) const noexcept
+			{
+				return stats[stl::to_underlying(a_stat)][a_pos];
+			}
+
+			[[nodiscard]] std::optional<std::uint32_t> position(std::uint32_t a_formID) const
+			{
+				auto iter = std::lower_bound(formIDs, formIDs + count, a_formID);
+				if (iter == formIDs + count || *iter != a_formID)
+				{
+					return std::nullopt;
+				}
+
+				return static_cast<std::uint32_t>(iter - formIDs);
+			}
+
+			[[nodiscard]] std::optional<std::string_view> find(std::uint32_t a_formID) const
+			{
+				auto iter = std::lower_bound(formIDs, formIDs + count, a_formID);
+				if (iter == formIDs + count || *iter != a_formID)
+				{
+					return std::nullopt;
+				}
+
+				return std::string_view{ names + nameOffsets[iter - formIDs] };
+			}
+
+		private:
+			const std::uint32_t* formIDs{ nullptr };
+			const std::uint32_t* nameOffsets{ nullptr };
+			const std::uint32_t* overrideOffsets{ nullptr };
+			StatColumns stats{};
+			const char* names{ nullptr };
+			const std::uint32_t* overrides{ nullptr };
+			std::uint32_t count{ 0 };
+		};
+
+		class Builder
+		{
+		public:
+			Builder()
+			{
+				sorted.fill(true);
+			}
+
+			void Reserve(FormCategory a_category, std::size_t a_count)
+			{
+				auto& entries = staged[stl::to_underlying(a_category)];
+				entries.reserve(entries.size() + a_count);
+			}
+
+			void Add(FormCategory a_category, std::uint32_t a_plugin, std::uint32_t a_formID, std::string_view a_name, const FormStats& a_stats = {}, std::span<const std::uint32_t> a_overrides = {})
+			{
+				auto category = stl::to_underlying(a_category);
+				staged[category].push_back({ a_plugin, a_formID, a_name, a_stats, static_cast<std::uint32_t>(overrides.size()), static_cast<std::uint32_t>(a_overrides.size()) });
+				overrides.insert(overrides.end(), a_overrides.begin(), a_overrides.end());
+				sorted[category] = false;
+			}
+
+			// For a name nothing else owns, such as a label made up during ingestion. Its parts are copied into the
+			// builder's own names, joined without a separator, and found again by offset since those grow.
+			void AddOwned(FormCategory a_category, std::uint32_t a_plugin, std::uint32_t a_formID, std::initializer_list<std::string_view> a_name, const FormStats& a_stats = {}, std::span<const std::uint32_t> a_overrides = {})
+			{
+				auto ownedName = static_cast<std::uint32_t>(ownedNames.size() + 1);
+				for (auto part : a_name)
+				{
+					ownedNames += part;
+				}
+
+				ownedNames += '\0';
+				Add(a_category, a_plugin, a_formID, {}, a_stats, a_overrides);
+				staged[stl::to_underlying(a_category)].back().ownedName = ownedName;
+			}
+
+			// Appends another builder's entries after this one's, keeping its sorted runs intact
+			void Merge(Builder&& a_other)
+			{
+				auto nameBase = static_cast<std::uint32_t>(ownedNames.size());
+				ownedNames += a_other.ownedNames;
+				a_other.ownedNames.clear();
+				a_other.ownedNames.shrink_to_fit();
+
+				auto overrideBase = static_cast<std::uint32_t>(overrides.size());
+				overrides.insert(overrides.end(), a_other.overrides.begin(), a_other.overrides.end());
+				a_other.overrides.clear();
+				a_other.overrides.shrink_to_fit();
+
+				for (std::uint32_t category = 0; category < CATEGORY_COUNT; category++)
+				{
+					auto& entries = staged[category];
+					auto& other = a_other.staged[category];
+					if (other.empty())
+					{
+						continue;
+					}
+
+					if (!a_other.sorted[category])
+					{
+						sorted[category] = false;
+					}
+					else
+					{
+						auto& bounds = runs[category];
+						if (!entries.empty())
+						{
+							bounds.push_back(entries.size());
+						}
+
+						for (auto bound : a_other.runs[category])
+						{
+							bounds.push_back(entries.size() + bound);
+						}
+					}
+
+					for (auto& entry : other)
+					{
+						entry.overrideBegin += overrideBase;
+						entry.ownedName += (entry.ownedName != 0) ? nameBase : 0;
+					}
+
+					entries.insert(entries.end(), other.begin(), other.end());
+					other.clear();
+					other.shrink_to_fit();
+					a_other.runs[category].clear();
+				}
+			}
+
+			// Equivalent to a stable sort of everything added so far, in the order it was added
+			void Sort(FormCategory a_category)
+			{
+				auto category = stl::to_underlying(a_category);
+				auto& entries = staged[category];
+				auto& bounds = runs[category];
+				if (!sorted[category])
+				{
+					std::stable_sort(entries.begin(), entries.end(), Compare);
+				}
+				else if (!bounds.empty())
+				{
+					bounds.insert(bounds.begin(), 0);
+					bounds.push_back(entries.size());
+					while (bounds.size() > 2)
+					{
+						std::vector<std::size_t> next;
+						for (std::size_t i = 0; i + 1 < bounds.size(); i += 2)
+						{
+							next.push_back(bounds[i]);
+							if (i + 2 < bounds.size())
+							{
+								std::inplace_merge(
+									entries.begin() + bounds[i],
+									entries.begin() + bounds[i + 1],
+									entries.begin() + bounds[i + 2],
+									Compare);
+							}
+						}
+
+						next.push_back(bounds.back());
+						bounds = std::move(next);
+					}
+				}
+
+				bounds.clear();
+				sorted[category] = true;
+			}
+
+			[[nodiscard]] FormIndex Build(std::size_t a_pluginCount)
+			{
+				Header header{};
+				header.magic = MAGIC;
+				header.version = VERSION;
+				header.pluginCount = static_cast<std::uint32_t>(a_pluginCount);
+				header.categoryCount = CATEGORY_COUNT;
+
+				for (std::uint32_t category = 0; category < CATEGORY_COUNT; category++)
+				{
+					Sort(static_cast<FormCategory>(category));
+
+					// Later additions of the same form replace earlier ones
+					auto& entries = staged[category];
+					auto last = entries.begin();
+					for (auto iter = entries.begin(); iter != entries.end(); ++iter)
+					{
+						auto next = std::next(iter);
+						if (next == entries.end() || next->plugin != iter->plugin || next->formID != iter->formID)
+						{
+							*last++ = *iter;
+						}
+					}
+
+					entries.erase(last, entries.end());
+					header.columnSizes[category] = static_cast<std::uint32_t>(entries.size());
+					for (auto& entry : entries)
+					{
+						// Owned names stop moving once nothing more is added
+						if (entry.ownedName != 0)
+						{
+							entry.name = ownedNames.c_str() + entry.ownedName - 1;
+						}
+
+						header.nameBytes += entry.name.size() + 1;
+						header.overrideCount += entry.overrideCount;
+					}
+				}
+
+				auto layout = GetLayout(header);
+				auto storage = std::make_shared<std::vector<std::byte>>(layout.size);
+				auto image = storage->data();
+				std::memcpy(image, std::addressof(header), sizeof(Header));
+
+				auto ranges = reinterpret_cast<RangeList*>(image + layout.ranges);
+
+				auto names = reinterpret_cast<char*>(image + layout.names);
+				auto overrideSlots = reinterpret_cast<std::uint32_t*>(image + layout.overrides);
+				std::uint32_t nameOffset{ 0 };
+				std::uint32_t overrideOffset{ 0 };
+				for (std::uint32_t category = 0; category < CATEGORY_COUNT; category++)
+				{
+					auto formIDs = reinterpret_cast<std::uint32_t*>(image + layout.formIDs[category]);
+					auto nameOffsets = reinterpret_cast<std::uint32_t*>(image + layout.nameOffsets[category]);
+					auto overrideOffsets = reinterpret_cast<std::uint32_t*>(image + layout.overrideOffsets[category]);
+					std::array<float*, STAT_COUNT> stats;
+					for (std::uint32_t stat = 0; stat < STAT_COUNT; stat++)
+					{
+						stats[stat] = reinterpret_cast<float*>(image + layout.stats[category][stat]);
+					}
+
+					auto& entries = staged[category];
+					// Ranges partition the column in plugin order, including empty ones
+					std::uint32_t pos{ 0 };
+					for (std::uint32_t plugin = 0; plugin < a_pluginCount; plugin++)
+					{
+						auto& range = ranges[plugin][category];
+						range.begin = pos;
+						for (; pos < entries.size() && entries[pos].plugin == plugin; pos++)
+						{
+							auto& entry = entries[pos];
+							formIDs[pos] = entry.formID;
+							nameOffsets[pos] = nameOffset;
+							std::memcpy(names + nameOffset, entry.name.data(), entry.name.size());
+							nameOffset += static_cast<std::uint32_t>(entry.name.size());
+							names[nameOffset++] = '\0';
+
+							for (std::uint32_t stat = 0; stat < STAT_COUNT; stat++)
+							{
+								stats[stat][pos] = entry.stats[stat];
+							}
+
+							overrideOffsets[pos] = overrideOffset;
+							std::copy_n(overrides.data() + entry.overrideBegin, entry.overrideCount, overrideSlots + overrideOffset);
+							overrideOffset += entry.overrideCount;
+						}
+
+						range.end = pos;
+					}
+
+					overrideOffsets[entries.size()] = overrideOffset;
+
+					entries.clear();
+					entries.shrink_to_fit();
+				}
+
+				overrides.clear();
+				overrides.shrink_to_fit();
+				ownedNames.clear();
+				ownedNames.shrink_to_fit();
+
+				std::span<const std::byte> view{ storage->data(), storage->size() };
+				return FormIndex{ std::move(storage), view };
+			}
+
+		private:
+			struct Entry
+			{
+				std::uint32_t plugin;
+				std::uint32_t formID;
+				std::string_view name;
+				FormStats stats;
+				std::uint32_t overrideBegin;
+				std::uint32_t overrideCount;
+				std::uint32_t ownedName{ 0 };  // Offset into ownedNames plus one, 0 for a name owned elsewhere
+			};
+
+			static bool Compare(const Entry& a_lhs, const Entry& a_rhs) noexcept
+			{
+				return (a_lhs.plugin != a_rhs.plugin) ? (a_lhs.plugin < a_rhs.plugin) : (a_lhs.formID < a_rhs.formID);
+			}
+
+			std::array<std::vector<Entry>, CATEGORY_COUNT> staged;
+			std::array<std::vector<std::size_t>, CATEGORY_COUNT> runs;
+			std::array<bool, CATEGORY_COUNT> sorted{};
+			std::vector<std::uint32_t> overrides;
+			std::string ownedNames;
+		};
+
+		FormIndex() = default;
+
+		// Checks that a serialized image is internally consistent before viewing it
+		[[nodiscard]] static std::optional<FormIndex> Attach(std::shared_ptr<const void> a_storage, std::span<const std::byte> a_image)
+		{
+			if (a_image.size() < sizeof(Header))
+			{
+				return std::nullopt;
+			}
+
+			auto header = reinterpret_cast<const Header*>(a_image.data());
+			if (header->magic != MAGIC || header->version != VERSION || header->categoryCount != CATEGORY_COUNT)
+			{
+				return std::nullopt;
+			}
+
+			if (header->nameBytes > std::numeric_limits<std::uint32_t>::max() ||
+				header->overrideCount > std::numeric_limits<std::uint32_t>::max() ||
+				GetLayout(*header).size != a_image.size())
+			{
+				return std::nullopt;
+			}
+
+			FormIndex index{ std::move(a_storage), a_image };
+			for (std::uint32_t category = 0; category < CATEGORY_COUNT; category++)
+			{
+				std::uint32_t pos{ 0 };
+				for (auto& rangeList : index.ranges)
+				{
+					auto& range = rangeList[category];
+					if (range.begin != pos || range.end < range.begin)
+					{
+						return std::nullopt;
+					}
+
+					pos = range.end;
+				}
+
+				if (pos != header->columnSizes[category])
+				{
+					return std::nullopt;
+				}
+			}
+
+			// Names are laid out in column order, which lets a position in the arena be mapped back to its form
+			std::uint64_t nextOffset{ 0 };
+			for (auto& column : index.columns)
+			{
+				for (auto nameOffset : column.nameOffsets)
+				{
+					if (nameOffset < nextOffset || nameOffset >= index.names.size())
+					{
+						return std::nullopt;
+					}
+
+					nextOffset = std::uint64_t{ nameOffset } + 1;
+				}
+			}
+
+			if (!index.names.empty() && index.names.back() != '\0')
+			{
+				return std::nullopt;
+			}
+
+			// Override lists follow each other through the arena in column order as well
+			std::uint32_t nextOverride{ 0 };
+			for (auto& column : index.columns)
+			{
+				if (column.overrideOffsets.front() != nextOverride)
+				{
+					return std::nullopt;
+				}
+
+				for (std::size_t pos = 1; pos < column.overrideOffsets.size(); pos++)
+				{
+					if (column.overrideOffsets[pos] < column.overrideOffsets[pos - 1])
+					{
+						return std::nullopt;
+					}
+				}
+
+				nextOverride = column.overrideOffsets.back();
+			}
+
+			if (nextOverride != index.overrides.size())
+			{
+				return std::nullopt;
+			}
+
+			for (auto plugin : index.overrides)
+			{
+				if (plugin >= index.ranges.size())
+				{
+					return std::nullopt;
+				}
+			}
+
+			return index;
+		}
+
+		[[nodiscard]] FormList GetForms(std::uint32_t a_plugin, FormCategory a_category) const noexcept
+		{
+			if (a_plugin >= ranges.size())
+			{
+				return {};
+			}
+
+			auto& column = columns[stl::to_underlying(a_category)];
+			auto& range = ranges[a_plugin][stl::to_underlying(a_category)];
+			return {
+				column.formIDs.data() + range.begin,
+				column.nameOffsets.data() + range.begin,
+				column.overrideOffsets.data() + range.begin,
+				column.GetStats(range.begin),
+				names.data(),
+				overrides.data(),
+				range.end - range.begin
+			};
+		}
+
+		[[nodiscard]] std::uint64_t GetCount(std::uint32_t a_plugin) const noexcept
+		{
+			std::uint64_t result{ 0 };
+			if (a_plugin < ranges.size())
+			{
+				for (auto& range : ranges[a_plugin])
+				{
+					result += range.end - range.begin;
+				}
+			}
+
+			return result;
+		}
+
+		[[nodiscard]] std::size_t GetFormCount() const noexcept
+		{
+			std::size_t result{ 0 };
+			for (auto& column : columns)
+			{
+				result += column.formIDs.size();
+			}
+
+			return result;
+		}
+
+		// The whole column, across all plugins
+		[[nodiscard]] FormList GetForms(FormCategory a_category) const noexcept
+		{
+			auto& column = columns[stl::to_underlying(a_category)];
+			return {
+				column.formIDs.data(),
+				column.nameOffsets.data(),
+				column.overrideOffsets.data(),
+				column.GetStats(0),
+				names.data(),
+				overrides.data(),
+				static_cast<std::uint32_t>(column.formIDs.size())
+			};
+		}
+
+		[[nodiscard]] std::uint32_t GetPlugin(FormCategory a_category, std::uint32_t a_pos) const noexcept
+		{
+			auto category = stl::to_underlying(a_category);
+			auto iter = std::upper_bound(
+				ranges.begin(),
+				ranges.end(),
+				a_pos,
+				[&](std::uint32_t a_value, const RangeList& a_rangeList)
+				{
+					return a_value < a_rangeList[category].end;
+				});
+			return static_cast<std::uint32_t>(iter - ranges.begin());
+		}
+
+		[[nodiscard]] std::size_t GetPluginCount() const noexcept { return ranges.size(); }
+		[[nodiscard]] std::span<const char> GetNames() const noexcept { return names; }
+		[[nodiscard]] std::size_t GetByteSize() const noexcept { return image.size(); }
+		[[nodiscard]] std::span<const std::byte> GetImage() const noexcept { return image; }
+
+	private:
+		struct Column
+		{
+			std::span<const std::uint32_t> formIDs;
+			std::span<const std::uint32_t> nameOffsets;
+			std::span<const std::uint32_t> overrideOffsets;
+			std::array<std::span<const float>, STAT_COUNT> stats;
+
+			[[nodiscard]] FormList::StatColumns GetStats(std::uint32_t a_begin) const noexcept
+			{
+				FormList::StatColumns result;
+				for (std::uint32_t stat = 0; stat < STAT_COUNT; stat++)
+				{
+					result[stat] = stats[stat].data() + a_begin;
+				}
+
+				return result;
+			}
+		};
+
+		struct Layout
+		{
+			std::size_t ranges;
+			std::array<std::size_t, CATEGORY_COUNT> formIDs;
+			std::array<std::size_t, CATEGORY_COUNT> nameOffsets;
+			std::array<std::size_t, CATEGORY_COUNT> overrideOffsets;
+			std::array<std::array<std::size_t, STAT_COUNT>, CATEGORY_COUNT> stats;
+			std::size_t overrides;
+			std::size_t names;
+			std::size_t size;
+		};
+
+		FormIndex(std::shared_ptr<const void> a_storage, std::span<const std::byte> a_image) :
+			storage(std::move(a_storage)),
+			image(a_image)
+		{
+			auto header = reinterpret_cast<const Header*>(image.data());
+			auto layout = GetLayout(*header);
+			ranges = { reinterpret_cast<const RangeList*>(image.data() + layout.ranges), header->pluginCount };
+			for (std::uint32_t category = 0; category < CATEGORY_COUNT; category++)
+			{
+				auto size = header->columnSizes[category];
+				columns[category].formIDs = { reinterpret_cast<const std::uint32_t*>(image.data() + layout.formIDs[category]), size };
+				columns[category].nameOffsets = { reinterpret_cast<const std::uint32_t*>(image.data() + layout.nameOffsets[category]), size };
+				columns[category].overrideOffsets = { reinterpret_cast<const std::uint32_t*>(image.data() + layout.overrideOffsets[category]), std::size_t{ size } + 1 };
+				for (std::uint32_t stat = 0; stat < STAT_COUNT; stat++)
+				{
+					columns[category].stats[stat] = { reinterpret_cast<const float*>(image.data() + layout.stats[category][stat]), size };
+				}
+			}
+
+			overrides = { reinterpret_cast<const std::uint32_t*>(image.data() + layout.overrides), static_cast<std::size_t>(header->overrideCount) };
+
+			names = { reinterpret_cast<const char*>(image.data() + layout.names), static_cast<std::size_t>(header->nameBytes) };
+		}
+
+		static Layout GetLayout(const Header& a_header) noexcept
+		{
+			Layout layout{};
+			layout.ranges = sizeof(Header);
+			layout.size = layout.ranges + std::size_t{ a_header.pluginCount } * sizeof(RangeList);
+			for (std::uint32_t category = 0; category < CATEGORY_COUNT; category++)
+			{
+				auto columnBytes = std::size_t{ a_header.columnSizes[category] } * sizeof(std::uint32_t);
+				layout.formIDs[category] = layout.size;
+				layout.nameOffsets[category] = layout.size + columnBytes;
+				layout.overrideOffsets[category] = layout.size + columnBytes * 2;
+				layout.size += columnBytes * 3 + sizeof(std::uint32_t);
+
+				// Stats are stored one column per stat, so range queries scan contiguous floats
+				for (std::uint32_t stat = 0; stat < STAT_COUNT; stat++)
+				{
+					layout.stats[category][stat] = layout.size;
+					layout.size += std::size_t{ a_header.columnSizes[category] } * sizeof(float);
+				}
+			}
+
+			layout.overrides = layout.size;
+			layout.size += static_cast<std::size_t>(a_header.overrideCount) * sizeof(std::uint32_t);
+			layout.names = layout.size;
+			layout.size += static_cast<std::size_t>(a_header.nameBytes);
+			return layout;
+		}
+
+		std::shared_ptr<const void> storage;
+		std::span<const std::byte> image;
+		std::span<const RangeList> ranges;
+		std::array<Column, CATEGORY_COUNT> columns;
+		std::span<const std::uint32_t> overrides;
+		std::span<const char> names;
+	};
+}
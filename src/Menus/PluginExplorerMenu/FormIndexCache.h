@@ -0,0 +1,91 @@
+#pragma once
+#include "FormIndex.h"
+#include "Menus/Utils/Fingerprint/Fingerprint.h"
+
+namespace Menus
+{
+	class FormIndexCache
+	{
+	public:
+		[[nodiscard]] static std::optional<FormIndex> Load(const std::filesystem::path& a_path, std::uint64_t a_fingerprint)
+		{
+			std::error_code ec;
+			if (!std::filesystem::exists(a_path, ec))
+			{
+				return std::nullopt;
+			}
+
+			try
+			{
+				auto file = std::make_shared<boost::iostreams::mapped_file_source>(a_path.string());
+				std::span<const std::byte> image{ reinterpret_cast<const std::byte*>(file->data()), file->size() };
+				if (image.size() < sizeof(FormIndex::Header))
+				{
+					return std::nullopt;
+				}
+
+				auto header = reinterpret_cast<const FormIndex::Header*>(image.data());
+				if (header->fingerprint != a_fingerprint)
+				{
+					logger::debug("PluginExplorer: Index cache is out of date."sv);
+					return std::nullopt;
+				}
+
+				auto index = FormIndex::Attach(std::move(file), image);
+				if (!index)
+				{
+					logger::warn("PluginExplorer: Index cache failed validation."sv);
+				}
+
+				return index;
+			}
+			catch (const std::exception& e)
+			{
+				logger::warn(FMT_STRING("PluginExplorer: Failed to map index cache: {:s}"), e.what());
+				return std::nullopt;
+			}
+		}
+
+		static bool Save(const std::filesystem::path& a_path, const FormIndex& a_index, std::uint64_t a_fingerprint)
+		{
+			auto image = a_index.GetImage();
+			if (image.size() < sizeof(FormIndex::Header))
+			{
+				return false;
+			}
+
+			auto header = *reinterpret_cast<const FormIndex::Header*>(image.data());
+			header.fingerprint = a_fingerprint;
+
+			// Write beside the cache and swap it in, so a partial write never replaces a good cache
+			auto tempPath = a_path;
+			tempPath += ".tmp";
+
+			{
+				std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+				if (!file)
+				{
+					return false;
+				}
+
+				file.write(reinterpret_cast<const char*>(std::addressof(header)), sizeof(header));
+				file.write(reinterpret_cast<const char*>(image.data() + sizeof(header)), image.size() - sizeof(header));
+				if (!file)
+				{
+					return false;
+				}
+			}
+
+			std::error_code ec;
+			std::filesystem::rename(tempPath, a_path, ec);
+			if (ec)
+			{
+				logger::warn(FMT_STRING("PluginExplorer: Failed to replace index cache: {:s}"), ec.message());
+				std::filesystem::remove(tempPath, ec);
+				return false;
+			}
+
+			return true;
+		}
+	};
+}
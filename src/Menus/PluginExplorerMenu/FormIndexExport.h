@@ -0,0 +1,212 @@
+#pragma once
+#include "FormIndex.h"
+#include "FormLabel.h"
+
+namespace Menus
+{
+	// Streams every indexed form to a file one record at a time, grouped by plugin and then category.
+	// Nothing but a fixed-size write buffer is allocated, however large the index is.
+	//
+	// The binary format is little-endian without padding:
+	//   u32 magic, u32 version, u32 pluginCount, u32 categoryCount, u64 recordCount
+	//   pluginCount plugin names, then categoryCount category names, each as a u16 length and its bytes
+	//   recordCount records, each as a u32 formID, u16 plugin, u8 category, u16 name length and the name bytes
+	class FormIndexExport
+	{
+	public:
+		enum class Format : std::uint32_t
+		{
+			kJSONL,
+			kBinary
+		};
+
+		static constexpr std::array<std::string_view, 2> FORMAT_NAMES{ "JSONL"sv, "Binary"sv };
+		static constexpr std::array<std::string_view, 2> FORMAT_EXTENSIONS{ ".jsonl"sv, ".bin"sv };
+
+		static constexpr std::uint32_t MAGIC{ 'B' | ('K' << 8) | ('E' << 16) | ('X' << 24) };
+		static constexpr std::uint32_t VERSION{ 1 };
+
+		class Writer
+		{
+		public:
+			static constexpr std::size_t BUFFER_SIZE{ 0x10000 };
+
+			explicit Writer(const std::filesystem::path& a_path) :
+				file(a_path, std::ios::binary | std::ios::trunc),
+				buffer(BUFFER_SIZE)
+			{}
+
+			[[nodiscard]] explicit operator bool() const noexcept { return static_cast<bool>(file); }
+			[[nodiscard]] std::uint64_t GetByteCount() const noexcept { return written + used; }
+
+			void Write(char a_char)
+			{
+				if (used == buffer.size())
+				{
+					Flush();
+				}
+
+				buffer[used++] = a_char;
+			}
+
+			void Write(std::string_view a_string)
+			{
+				Write(a_string.data(), a_string.size());
+			}
+
+			void Write(const void* a_data, std::size_t a_size)
+			{
+				auto bytes = static_cast<const char*>(a_data);
+				while (a_size > 0)
+				{
+					if (used == buffer.size())
+					{
+						Flush();
+					}
+
+					auto count = std::min(a_size, buffer.size() - used);
+					std::memcpy(buffer.data() + used, bytes, count);
+					used += count;
+					bytes += count;
+					a_size -= count;
+				}
+			}
+
+			template<class T>
+			void WriteValue(T a_value)
+				requires(std::is_integral_v<T>)
+			{
+				static_assert(std::endian::native == std::endian::little);
+				Write(std::addressof(a_value), sizeof(a_value));
+			}
+
+			bool Flush()
+			{
+				file.write(buffer.data(), used);
+				written += used;
+				used = 0;
+				return static_cast<bool>(file);
+			}
+
+		private:
+			std::ofstream file;
+			std::vector<char> buffer;
+			std::size_t used{ 0 };
+			std::uint64_t written{ 0 };
+		};
+
+		// Returns the number of records written
+		[[nodiscard]] static std::optional<std::uint64_t> Export(const std::filesystem::path& a_path, const FormIndex& a_index, std::span<const std::string_view> a_plugins, Format a_format)
+		{
+			if (a_plugins.size() != a_index.GetPluginCount() || a_plugins.size() > std::numeric_limits<std::uint16_t>::max())
+			{
+				return std::nullopt;
+			}
+
+			Writer writer{ a_path };
+			if (!writer)
+			{
+				return std::nullopt;
+			}
+
+			if (a_format == Format::kBinary)
+			{
+				writer.WriteValue(MAGIC);
+				writer.WriteValue(VERSION);
+				writer.WriteValue(static_cast<std::uint32_t>(a_plugins.size()));
+				writer.WriteValue(FormIndex::CATEGORY_COUNT);
+				writer.WriteValue(static_cast<std::uint64_t>(a_index.GetFormCount()));
+				for (auto plugin : a_plugins)
+				{
+					WriteString(writer, plugin);
+				}
+
+				for (auto category : FormIndex::CATEGORY_NAMES)
+				{
+					WriteString(writer, category);
+				}
+			}
+
+			std::uint64_t count{ 0 };
+			for (std::uint32_t plugin = 0; plugin < a_plugins.size(); plugin++)
+			{
+				for (std::uint32_t category = 0; category < FormIndex::CATEGORY_COUNT; category++)
+				{
+					for (auto [formID, name] : a_index.GetForms(plugin, static_cast<FormCategory>(category)))
+					{
+						if (a_format == Format::kBinary)
+						{
+							writer.WriteValue(formID);
+							writer.WriteValue(static_cast<std::uint16_t>(plugin));
+							writer.WriteValue(static_cast<std::uint8_t>(category));
+							WriteString(writer, name);
+						}
+						else
+						{
+							writer.Write(R"({"plugin":")"sv);
+							WriteEscaped(writer, a_plugins[plugin]);
+							writer.Write(R"(","category":")"sv);
+							writer.Write(FormIndex::CATEGORY_NAMES[category]);
+							writer.Write(R"(","formID":")"sv);
+							writer.Write(FormLabel::FormID(formID).view().substr(1, 8));
+							writer.Write(R"(","name":")"sv);
+							WriteEscaped(writer, name);
+							writer.Write("\"}\n"sv);
+						}
+
+						count++;
+					}
+				}
+			}
+
+			if (!writer.Flush())
+			{
+				return std::nullopt;
+			}
+
+			return count;
+		}
+
+	private:
+		// Anything longer than a u16 length can describe is cut short
+		static void WriteString(Writer& a_writer, std::string_view a_string)
+		{
+			auto size = std::min<std::size_t>(a_string.size(), std::numeric_limits<std::uint16_t>::max());
+			a_writer.WriteValue(static_cast<std::uint16_t>(size));
+			a_writer.Write(a_string.data(), size);
+		}
+
+		// Names are written in whatever encoding the plugin used, only quotes, backslashes and control characters are escaped
+		static void WriteEscaped(Writer& a_writer, std::string_view a_string)
+		{
+			static constexpr std::string_view HEX_DIGITS{ "0123456789abcdef"sv };
+
+			std::size_t begin{ 0 };
+			for (std::size_t i = 0; i < a_string.size(); i++)
+			{
+				auto ch = static_cast<std::uint8_t>(a_string[i]);
+				if (ch >= 0x20 && ch != '"' && ch != '\\')
+				{
+					continue;
+				}
+
+				a_writer.Write(a_string.substr(begin, i - begin));
+				a_writer.Write('\\');
+				if (ch == '"' || ch == '\\')
+				{
+					a_writer.Write(static_cast<char>(ch));
+				}
+				else
+				{
+					a_writer.Write("u00"sv);
+					a_writer.Write(HEX_DIGITS[ch >> 4]);
+					a_writer.Write(HEX_DIGITS[ch & 0xF]);
+				}
+
+				begin = i + 1;
+			}
+
+			a_writer.Write(a_string.substr(begin));
+		}
+	};
+}
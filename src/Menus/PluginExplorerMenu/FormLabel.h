@@ -0,0 +1,65 @@
+#pragma once
+
+namespace Menus
+{
+	// Fixed-width "[XXXXXXXX]" style labels, written into an inline buffer so list population never allocates for them
+	class FormLabel
+	{
+	public:
+		static FormLabel FormID(std::uint32_t a_formID) noexcept
+		{
+			FormLabel result;
+			result.Append('[');
+			result.AppendHex<8>(a_formID);
+			result.Append(']');
+			return result;
+		}
+
+		static FormLabel Plugin(std::uint32_t a_compileIndex, std::uint32_t a_smallFileCompileIndex) noexcept
+		{
+			FormLabel result;
+			result.Append('[');
+			if (a_compileIndex == 0xFE)
+			{
+				result.AppendHex<2>(a_compileIndex);
+				result.Append(']');
+				result.Append('[');
+				result.AppendHex<3>(a_smallFileCompileIndex);
+			}
+			else
+			{
+				result.AppendHex<2>(a_compileIndex);
+			}
+
+			result.Append(']');
+			return result;
+		}
+
+		[[nodiscard]] const char* c_str() const noexcept { return buffer.data(); }
+		[[nodiscard]] std::string_view view() const noexcept { return { buffer.data(), size }; }
+
+	private:
+		static constexpr std::string_view HEX_DIGITS{ "0123456789ABCDEF"sv };
+
+		FormLabel() = default;
+
+		void Append(char a_char) noexcept
+		{
+			buffer[size++] = a_char;
+		}
+
+		template<std::uint32_t DIGITS>
+		void AppendHex(std::uint32_t a_value) noexcept
+		{
+			for (std::uint32_t i = 0; i < DIGITS; i++)
+			{
+				buffer[size + i] = HEX_DIGITS[(a_value >> ((DIGITS - 1 - i) * 4)) & 0xF];
+			}
+
+			size += DIGITS;
+		}
+
+		std::array<char, 16> buffer{};
+		std::size_t size{ 0 };
+	};
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "FormIndex.h"
+#include "Menus/Utils/CpuFeatures/CpuFeatures.h"
+
+namespace Menus
+{
+	// Filters a form list on inclusive stat ranges, a form has to satisfy every predicate to match.
+	// Comparisons against NaN never hold, so a NaN bound matches nothing and a missing stat, stored as NaN, never
+	// matches, on every path.
+	class FormQuery
+	{
+	public:
+		using FormList = FormIndex::FormList;
+		using Path = Utils::CpuFeatures::Path;
+
+		struct Predicate
+		{
+			FormStat stat;
+			float min;
+			float max;
+		};
+
+		void Add(FormStat a_stat, float a_min, float a_max)
+		{
+			predicates.push_back({ a_stat, a_min, a_max });
+		}
+
+		[[nodiscard]] bool empty() const noexcept { return predicates.empty(); }
+		[[nodiscard]] std::span<const Predicate> GetPredicates() const noexcept { return predicates; }
+
+		// Returns the positions of the matching forms, in list order
+		[[nodiscard]] std::vector<std::uint32_t> Run(const FormList& a_forms, Path a_path = Utils::CpuFeatures::GetPath()) const
+		{
+			std::vector<std::uint32_t> result;
+			std::uint32_t pos{ 0 };
+			switch (a_path)
+			{
+				case Path::kAVX2:
+					pos = RunAVX2(a_forms, result);
+					break;
+				case Path::kSSE2:
+					pos = RunSSE2(a_forms, result);
+					break;
+				default:
+					break;
+			}
+
+			RunScalar(a_forms, result, pos);
+			return result;
+		}
+
+	private:
+		static void AddMatches(std::vector<std::uint32_t>& a_result, std::uint32_t a_pos, std::uint32_t a_mask)
+		{
+			for (; a_mask; a_mask &= a_mask - 1)
+			{
+				a_result.push_back(a_pos + std::countr_zero(a_mask));
+			}
+		}
+
+		void RunScalar(const FormList& a_forms, std::vector<std::uint32_t>& a_result, std::uint32_t a_pos) const
+		{
+			for (; a_pos < a_forms.size(); a_pos++)
+			{
+				auto matches = std::all_of(
+					predicates.begin(),
+					predicates.end(),
+					[&](const Predicate& a_predicate)
+					{
+						auto value = a_forms.stat(a_predicate.stat, a_pos);
+						return value >= a_predicate.min && value <= a_predicate.max;
+					});
+
+				if (matches)
+				{
+					a_result.push_back(a_pos);
+				}
+			}
+		}
+
+		// Each block is checked one predicate at a time, and dropped as soon as none of its forms can match.
+		// Returns where the scalar loop has to take over.
+		std::uint32_t RunSSE2(const FormList& a_forms, std::vector<std::uint32_t>& a_result) const
+		{
+			constexpr std::uint32_t WIDTH = 4;
+
+			std::uint32_t pos{ 0 };
+			for (; pos + WIDTH <= a_forms.size(); pos += WIDTH)
+			{
+				std::uint32_t mask{ (1u << WIDTH) - 1 };
+				for (auto& predicate : predicates)
+				{
+					auto values = _mm_loadu_ps(a_forms.stats_of(predicate.stat).data() + pos);
+					auto inside = _mm_and_ps(_mm_cmpge_ps(values, _mm_set1_ps(predicate.min)), _mm_cmple_ps(values, _mm_set1_ps(predicate.max)));
+					mask &= static_cast<std::uint32_t>(_mm_movemask_ps(inside));
+					if (!mask)
+					{
+						break;
+					}
+				}
+
+				AddMatches(a_result, pos, mask);
+			}
+
+			return pos;
+		}
+
+		std::uint32_t RunAVX2(const FormList& a_forms, std::vector<std::uint32_t>& a_result) const
+		{
+			constexpr std::uint32_t WIDTH = 8;
+
+			std::uint32_t pos{ 0 };
+			for (; pos + WIDTH <= a_forms.size(); pos += WIDTH)
+			{
+				std::uint32_t mask{ (1u << WIDTH) - 1 };
+				for (auto& predicate : predicates)
+				{
+					auto values = _mm256_loadu_ps(a_forms.stats_of(predicate.stat).data() + pos);
+					auto inside = _mm256_and_ps(
+						_mm256_cmp_ps(values, _mm256_set1_ps(predicate.min), _CMP_GE_OQ),
+						_mm256_cmp_ps(values, _mm256_set1_ps(predicate.max), _CMP_LE_OQ));
+					mask &= static_cast<std::uint32_t>(_mm256_movemask_ps(inside));
+					if (!mask)
+					{
+						break;
+					}
+				}
+
+				AddMatches(a_result, pos, mask);
+			}
+
+			return pos;
+		}
+
+		std::vector<Predicate> predicates;
+	};
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+namespace Menus
+{
+	enum class FormCategory : std::uint32_t;
+
+	// Numeric columns stored next to each category's formIDs, rating is base damage for weapons and armor rating for armor.
+	// A stat the form type has no component for is NaN, so no range query matches it.
+	enum class FormStat : std::uint32_t
+	{
+		kValue,
+		kWeight,
+		kRating,
+
+		kTotal
+	};
+
+	using FormStats = std::array<float, static_cast<std::size_t>(FormStat::kTotal)>;
+
+	template<class... CATEGORIES>
+	class FormTypeList
+	{
+	public:
+		static constexpr std::uint32_t SIZE{ sizeof...(CATEGORIES) };
+		static constexpr std::array<std::string_view, SIZE> KEYS{ CATEGORIES::KEY... };
+
+		template<class CATEGORY>
+		static constexpr FormCategory Get() noexcept
+		{
+			constexpr std::array<bool, SIZE> matches{ std::is_same_v<CATEGORY, CATEGORIES>... };
+			static_assert(std::ranges::count(matches, true) == 1, "Category must be registered exactly once");
+			return static_cast<FormCategory>(std::ranges::find(matches, true) - matches.begin());
+		}
+
+		// Only forms of these types may be spawned into an inventory from the explorer
+		static constexpr bool IsInventoryType(RE::ENUM_FORM_ID a_formType) noexcept
+		{
+			return (IsInventoryCategory<CATEGORIES>(a_formType) || ...);
+		}
+
+		// Calls a_func.operator()<CATEGORY>() for every category, in order
+		template<class FUNC>
+		static void ForEach(FUNC&& a_func)
+		{
+			(a_func.template operator()<CATEGORIES>(), ...);
+		}
+
+	private:
+		template<class CATEGORY>
+		static constexpr bool IsInventoryCategory(RE::ENUM_FORM_ID a_formType) noexcept
+		{
+			if constexpr (requires { CATEGORY::INVENTORY; })
+			{
+				return CATEGORY::form_type::FORM_ID == a_formType;
+			}
+			else
+			{
+				return false;
+			}
+		}
+	};
+
+	// Each category names the form type it is ingested from, or void if it is split off another category during ingestion.
+	// KEY is the category's name on the ActionScript side, INVENTORY marks categories that can be added to the player.
+	// GetStats reads stats the generic value and weight components do not cover. USE_EDITOR_ID names forms without a
+	// full name by their editor ID, or by their plugin's file name and FormID label where the editor ID is gone.
+	// SKIP_PLAYABLE lists forms without asking GetPlayable, for types where what it returns was never checked against
+	// the game.
+	namespace FormTypes
+	{
+		struct ALCH
+		{
+			using form_type = RE::AlchemyItem;
+			static constexpr auto KEY{ "ALCH"sv };
+			static constexpr bool INVENTORY{ true };
+		};
+
+		struct AMMO
+		{
+			using form_type = RE::TESAmmo;
+			static constexpr auto KEY{ "AMMO"sv };
+			static constexpr bool INVENTORY{ true };
+		};
+
+		struct ARMO
+		{
+			using form_type = RE::TESObjectARMO;
+			static constexpr auto KEY{ "ARMO"sv };
+			static constexpr bool INVENTORY{ true };
+
+			static FormStats GetStats(const RE::TESObjectARMO* a_form);
+		};
+
+		struct BOOK
+		{
+			using form_type = RE::TESObjectBOOK;
+			static constexpr auto KEY{ "BOOK"sv };
+			static constexpr bool INVENTORY{ true };
+		};
+
+		struct FLOR
+		{
+			using form_type = RE::TESFlora;
+			static constexpr auto KEY{ "FLOR"sv };
+			static constexpr bool SKIP_PLAYABLE{ true };
+		};
+
+		struct HOLO
+		{
+			using form_type = RE::BGSNote;
+			static constexpr auto KEY{ "HOLO"sv };
+			static constexpr bool INVENTORY{ true };
+		};
+
+		struct INGR
+		{
+			using form_type = RE::IngredientItem;
+			static constexpr auto KEY{ "INGR"sv };
+			static constexpr bool INVENTORY{ true };
+			static constexpr bool SKIP_PLAYABLE{ true };
+		};
+
+		struct JUNK
+		{
+			using form_type = void;
+			static constexpr auto KEY{ "JUNK"sv };
+		};
+
+		struct KEYS
+		{
+			using form_type = RE::TESKey;
+			static constexpr auto KEY{ "KEYS"sv };
+			static constexpr bool INVENTORY{ true };
+		};
+
+		// Not INVENTORY: adding a leveled list to a container adds the list itself, not an item resolved from it
+		struct LVLI
+		{
+			using form_type = RE::TESLevItem;
+			static constexpr auto KEY{ "LVLI"sv };
+			static constexpr bool USE_EDITOR_ID{ true };
+			static constexpr bool SKIP_PLAYABLE{ true };
+		};
+
+		struct MISC
+		{
+			using form_type = RE::TESObjectMISC;
+			static constexpr auto KEY{ "MISC"sv };
+			static constexpr bool INVENTORY{ true };
+
+			static FormCategory Classify(RE::TESObjectMISC* a_form);
+		};
+
+		struct MODS
+		{
+			using form_type = void;
+			static constexpr auto KEY{ "MODS"sv };
+		};
+
+		struct NPC_
+		{
+			using form_type = RE::TESNPC;
+			static constexpr auto KEY{ "NPC_"sv };
+			static constexpr bool SKIP_PLAYABLE{ true };
+		};
+
+		struct OMOD
+		{
+			using form_type = RE::BGSMod::Attachment::Mod;
+			static constexpr auto KEY{ "OMOD"sv };
+			static constexpr bool SKIP_PLAYABLE{ true };
+		};
+
+		struct WEAP
+		{
+			using form_type = RE::TESObjectWEAP;
+			static constexpr auto KEY{ "WEAP"sv };
+			static constexpr bool INVENTORY{ true };
+
+			static FormStats GetStats(const RE::TESObjectWEAP* a_form);
+		};
+	}
+
+	// Adding a category only takes an entry here, ingestion, storage and the menu are all driven by this list
+	using FormRegistry = FormTypeList<
+		FormTypes::ALCH,
+		FormTypes::AMMO,
+		FormTypes::ARMO,
+		FormTypes::BOOK,
+		FormTypes::FLOR,
+		FormTypes::HOLO,
+		FormTypes::INGR,
+		FormTypes::JUNK,
+		FormTypes::KEYS,
+		FormTypes::LVLI,
+		FormTypes::MISC,
+		FormTypes::MODS,
+		FormTypes::NPC_,
+		FormTypes::OMOD,
+		FormTypes::WEAP>;
+
+	enum class FormCategory : std::uint32_t
+	{
+		kTotal = FormRegistry::SIZE
+	};
+
+	// Subcategories never change after data load, so they are resolved once at ingestion rather than on every open
+	inline FormCategory FormTypes::MISC::Classify(RE::TESObjectMISC* a_form)
+	{
+		if (a_form->componentData && a_form->componentData->size() > 0)
+		{
+			return FormRegistry::Get<JUNK>();
+		}
+
+		if (a_form->IsLooseMod())
+		{
+			return FormRegistry::Get<MODS>();
+		}
+
+		return FormRegistry::Get<MISC>();
+	}
+
+	inline FormStats FormTypes::ARMO::GetStats(const RE::TESObjectARMO* a_form)
+	{
+		auto& data = a_form->armorData;
+		return { static_cast<float>(data.value), data.weight, static_cast<float>(data.rating) };
+	}
+
+	inline FormStats FormTypes::WEAP::GetStats(const RE::TESObjectWEAP* a_form)
+	{
+		auto& data = a_form->weaponData;
+		return { static_cast<float>(data.value), data.weight, static_cast<float>(data.attackDamage) };
+	}
+}
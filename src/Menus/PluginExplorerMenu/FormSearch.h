@@ -0,0 +1,406 @@
+#pragma once
+#include "FormIndex.h"
+#include "NameScanner.h"
+
+namespace Menus
+{
+	class FormSearch
+	{
+	public:
+		// Matches are entries, numbered across every category column of the index in order
+		class Results
+		{
+		public:
+			[[nodiscard]] std::string_view GetQuery() const noexcept { return query; }
+			[[nodiscard]] std::size_t GetCount() const noexcept { return matches.size(); }
+
+			// Only as much of the ranking as has been paged through is ever sorted
+			[[nodiscard]] std::vector<std::uint32_t> GetRanked(std::size_t a_first, std::size_t a_count)
+			{
+				auto first = std::min(a_first, ranked.size());
+				auto last = std::min(first + a_count, ranked.size());
+				if (last > sortedCount)
+				{
+					std::nth_element(ranked.begin() + sortedCount, ranked.begin() + last - 1, ranked.end());
+					std::sort(ranked.begin() + sortedCount, ranked.begin() + last);
+					sortedCount = last;
+				}
+
+				std::vector<std::uint32_t> result;
+				result.reserve(last - first);
+				for (auto i = first; i < last; i++)
+				{
+					result.push_back(static_cast<std::uint32_t>(ranked[i]));
+				}
+
+				return result;
+			}
+
+			void Clear()
+			{
+				query.clear();
+				matches.clear();
+				ranked.clear();
+				sortedCount = 0;
+			}
+
+		private:
+			friend class FormSearch;
+
+			std::string query;
+			std::vector<std::uint32_t> matches;
+			std::vector<std::uint64_t> ranked;
+			std::size_t sortedCount{ 0 };
+		};
+
+		FormSearch() = default;
+
+		explicit FormSearch(const FormIndex* a_formIndex) :
+			formIndex(a_formIndex)
+		{
+			auto names = formIndex->GetNames();
+			for (std::uint32_t category = 0; category < FormIndex::CATEGORY_COUNT; category++)
+			{
+				auto forms = formIndex->GetForms(static_cast<FormCategory>(category));
+				bases[category + 1] = bases[category] + forms.size();
+				for (auto entry : forms)
+				{
+					starts.push_back(static_cast<std::uint32_t>(entry.second.data() - names.data()));
+				}
+			}
+
+			// Postings are placed by two counting sorts, over the whole index by the first two characters of each
+			// trigram, then within each of those buckets by the third. Both keep entry order, and only one bucket
+			// is ever copied aside.
+			std::vector<std::uint32_t> counts(0x10001, 0);
+			ForEachTrigram(
+				[&](std::uint32_t a_trigram, std::uint32_t)
+				{
+					counts[(a_trigram >> 8) + 1]++;
+				});
+			std::partial_sum(counts.begin(), counts.end(), counts.begin());
+
+			std::vector<std::uint32_t> entries(counts.back());
+			std::vector<std::uint8_t> thirds(counts.back());
+			{
+				auto next = counts;
+				ForEachTrigram(
+					[&](std::uint32_t a_trigram, std::uint32_t a_entry)
+					{
+						auto i = next[a_trigram >> 8]++;
+						entries[i] = a_entry;
+						thirds[i] = static_cast<std::uint8_t>(a_trigram);
+					});
+			}
+
+			// Deduplicated postings are compacted into the front of entries, which never overtakes the bucket being read
+			std::size_t size{ 0 };
+			std::vector<std::uint32_t> bucket;
+			for (std::uint32_t prefix = 0; prefix < 0x10000; prefix++)
+			{
+				auto first = counts[prefix];
+				auto last = counts[prefix + 1];
+				if (first == last)
+				{
+					continue;
+				}
+
+				std::array<std::uint32_t, 0x101> thirdCounts{};
+				for (auto i = first; i < last; i++)
+				{
+					thirdCounts[thirds[i] + 1]++;
+				}
+
+				std::partial_sum(thirdCounts.begin(), thirdCounts.end(), thirdCounts.begin());
+				bucket.resize(last - first);
+				auto next = thirdCounts;
+				for (auto i = first; i < last; i++)
+				{
+					bucket[next[thirds[i]]++] = entries[i];
+				}
+
+				for (std::uint32_t third = 0; third < 0x100; third++)
+				{
+					if (thirdCounts[third] == thirdCounts[third + 1])
+					{
+						continue;
+					}
+
+					keys.push_back((prefix << 8) | third);
+					offsets.push_back(static_cast<std::uint32_t>(size));
+					for (auto i = thirdCounts[third]; i < thirdCounts[third + 1]; i++)
+					{
+						if (i == thirdCounts[third] || bucket[i] != bucket[i - 1])
+						{
+							entries[size++] = bucket[i];
+						}
+					}
+				}
+			}
+
+			thirds.clear();
+			thirds.shrink_to_fit();
+			bucket.clear();
+			bucket.shrink_to_fit();
+
+			entries.resize(size);
+			entries.shrink_to_fit();
+			postings = std::move(entries);
+			offsets.push_back(static_cast<std::uint32_t>(postings.size()));
+		}
+
+		// Reuses the previous results when the new query only extends them
+		void Search(std::string_view a_query, Results& a_results) const
+		{
+			std::string query{ a_query };
+			std::transform(query.begin(), query.end(), query.begin(), ToLower);
+			if (!a_results.query.empty() && query == a_results.query)
+			{
+				return;
+			}
+
+			if (query.empty())
+			{
+				a_results.Clear();
+				return;
+			}
+
+			bool refine = !a_results.query.empty() && query.find(a_results.query) != std::string::npos;
+			a_results.matches = Find(query, refine ? std::addressof(a_results.matches) : nullptr);
+			a_results.ranked = Rank(query, a_results.matches);
+			a_results.sortedCount = 0;
+			a_results.query = std::move(query);
+		}
+
+		[[nodiscard]] FormCategory GetCategory(std::uint32_t a_entry) const noexcept
+		{
+			auto iter = std::upper_bound(bases.begin(), bases.end(), a_entry);
+			return static_cast<FormCategory>((iter - bases.begin()) - 1);
+		}
+
+		[[nodiscard]] std::uint32_t GetPosition(std::uint32_t a_entry) const noexcept
+		{
+			return a_entry - bases[stl::to_underlying(GetCategory(a_entry))];
+		}
+
+		[[nodiscard]] std::uint32_t GetFormID(std::uint32_t a_entry) const noexcept
+		{
+			return formIndex->GetForms(GetCategory(a_entry))[GetPosition(a_entry)].first;
+		}
+
+		[[nodiscard]] std::string_view GetName(std::uint32_t a_entry) const noexcept
+		{
+			return formIndex->GetForms(GetCategory(a_entry))[GetPosition(a_entry)].second;
+		}
+
+		[[nodiscard]] std::uint32_t GetPlugin(std::uint32_t a_entry) const noexcept
+		{
+			return formIndex->GetPlugin(GetCategory(a_entry), GetPosition(a_entry));
+		}
+
+		[[nodiscard]] std::size_t GetTrigramCount() const noexcept { return keys.size(); }
+
+		[[nodiscard]] std::size_t GetByteSize() const noexcept
+		{
+			return (starts.size() + keys.size() + offsets.size() + postings.size()) * sizeof(std::uint32_t);
+		}
+
+	private:
+		enum class Rating : std::uint32_t
+		{
+			kExact,
+			kPrefix,
+			kWordStart,
+			kInfix
+		};
+
+		static char ToLower(char a_char) noexcept
+		{
+			return (a_char >= 'A' && a_char <= 'Z') ? static_cast<char>(a_char + ('a' - 'A')) : a_char;
+		}
+
+		static std::uint32_t GetTrigram(char a_first, char a_second, char a_third) noexcept
+		{
+			return (std::uint32_t{ static_cast<std::uint8_t>(ToLower(a_first)) } << 16) |
+			       (std::uint32_t{ static_cast<std::uint8_t>(ToLower(a_second)) } << 8) |
+			       std::uint32_t{ static_cast<std::uint8_t>(ToLower(a_third)) };
+		}
+
+		template<class FUNC>
+		void ForEachTrigram(FUNC a_func) const
+		{
+			for (std::uint32_t entry = 0; entry < bases.back(); entry++)
+			{
+				auto name = GetName(entry);
+				for (std::size_t i = 2; i < name.size(); i++)
+				{
+					a_func(GetTrigram(name[i - 2], name[i - 1], name[i]), entry);
+				}
+			}
+		}
+
+		// Case-insensitive search for an already lowercase query
+		static std::size_t FindIn(std::string_view a_name, std::string_view a_query, std::size_t a_from = 0) noexcept
+		{
+			for (std::size_t pos = a_from; pos + a_query.size() <= a_name.size(); pos++)
+			{
+				std::size_t i = 0;
+				while (i < a_query.size() && ToLower(a_name[pos + i]) == a_query[i])
+				{
+					i++;
+				}
+
+				if (i == a_query.size())
+				{
+					return pos;
+				}
+			}
+
+			return std::string_view::npos;
+		}
+
+		static bool IsWordChar(char a_char) noexcept
+		{
+			return std::isalnum(static_cast<unsigned char>(a_char)) || (static_cast<unsigned char>(a_char) >= 0x80);
+		}
+
+		[[nodiscard]] std::span<const std::uint32_t> GetPostings(std::uint32_t a_trigram) const noexcept
+		{
+			auto iter = std::lower_bound(keys.begin(), keys.end(), a_trigram);
+			if (iter == keys.end() || *iter != a_trigram)
+			{
+				return {};
+			}
+
+			auto index = iter - keys.begin();
+			return { postings.data() + offsets[index], postings.data() + offsets[index + 1] };
+		}
+
+		// Returns the matching entries in entry order
+		[[nodiscard]] std::vector<std::uint32_t> Find(std::string_view a_query, const std::vector<std::uint32_t>* a_within) const
+		{
+			std::vector<std::uint32_t> candidates;
+			if (a_query.size() >= 3)
+			{
+				std::vector<std::span<const std::uint32_t>> lists;
+				for (std::size_t i = 2; i < a_query.size(); i++)
+				{
+					auto list = GetPostings(GetTrigram(a_query[i - 2], a_query[i - 1], a_query[i]));
+					if (list.empty())
+					{
+						return {};
+					}
+
+					lists.push_back(list);
+				}
+
+				std::sort(
+					lists.begin(),
+					lists.end(),
+					[](auto& a_lhs, auto& a_rhs)
+					{
+						return a_lhs.size() < a_rhs.size();
+					});
+
+				// Previous results are already a superset, so they are only worth intersecting when smaller
+				if (a_within && a_within->size() <= lists.front().size())
+				{
+					candidates = *a_within;
+				}
+				else
+				{
+					candidates.assign(lists.front().begin(), lists.front().end());
+					lists.erase(lists.begin());
+				}
+
+				std::vector<std::uint32_t> intersection;
+				for (auto& list : lists)
+				{
+					if (candidates.empty())
+					{
+						break;
+					}
+
+					intersection.clear();
+					std::set_intersection(
+						candidates.begin(),
+						candidates.end(),
+						list.begin(),
+						list.end(),
+						std::back_inserter(intersection));
+					candidates.swap(intersection);
+				}
+			}
+			else if (a_within)
+			{
+				candidates = *a_within;
+			}
+			else
+			{
+				// Too short for trigrams, so scan the name arena for it directly
+				auto names = formIndex->GetNames();
+				NameScanner::Scan(
+					names,
+					a_query,
+					[&](std::size_t a_offset)
+					{
+						auto next = std::upper_bound(starts.begin(), starts.end(), a_offset);
+						candidates.push_back(static_cast<std::uint32_t>((next - starts.begin()) - 1));
+						return (next != starts.end()) ? std::size_t{ *next } : names.size();
+					});
+				return candidates;
+			}
+
+			// Trigrams only narrow the candidates, the name must still contain the whole query
+			std::erase_if(
+				candidates,
+				[&](std::uint32_t a_entry)
+				{
+					return FindIn(GetName(a_entry), a_query) == std::string_view::npos;
+				});
+			return candidates;
+		}
+
+		[[nodiscard]] Rating GetRating(std::string_view a_name, std::string_view a_query) const noexcept
+		{
+			auto pos = FindIn(a_name, a_query);
+			if (pos == 0)
+			{
+				return (a_name.size() == a_query.size()) ? Rating::kExact : Rating::kPrefix;
+			}
+
+			for (; pos != std::string_view::npos; pos = FindIn(a_name, a_query, pos + 1))
+			{
+				if (!IsWordChar(a_name[pos - 1]))
+				{
+					return Rating::kWordStart;
+				}
+			}
+
+			return Rating::kInfix;
+		}
+
+		// Keys order by how the query matched, then by shorter names, then by entry
+		[[nodiscard]] std::vector<std::uint64_t> Rank(std::string_view a_query, const std::vector<std::uint32_t>& a_matches) const
+		{
+			std::vector<std::uint64_t> result;
+			result.reserve(a_matches.size());
+			for (auto entry : a_matches)
+			{
+				auto name = GetName(entry);
+				auto rating = stl::to_underlying(GetRating(name, a_query));
+				auto length = std::min<std::size_t>(name.size(), 0x3FFFFFFF);
+				result.push_back((std::uint64_t{ rating } << 62) | (std::uint64_t{ length } << 32) | entry);
+			}
+
+			return result;
+		}
+
+		const FormIndex* formIndex{ nullptr };
+		std::array<std::uint32_t, FormIndex::CATEGORY_COUNT + 1> bases{};
+		std::vector<std::uint32_t> starts;
+		std::vector<std::uint32_t> keys;
+		std::vector<std::uint32_t> offsets;
+		std::vector<std::uint32_t> postings;
+	};
+}
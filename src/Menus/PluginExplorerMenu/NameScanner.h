@@ -0,0 +1,168 @@
+#pragma once
+#include "Menus/Utils/CpuFeatures/CpuFeatures.h"
+
+namespace Menus
+{
+	// Brute-force search of a NUL-separated name arena, folding ASCII case only.
+	// Bytes from 0x80 up are compared as-is, so a valid UTF-8 needle can only match on a character boundary.
+	class NameScanner
+	{
+	public:
+		using Path = Utils::CpuFeatures::Path;
+
+		// Calls a_func with the offset of each match, a_func returns the offset to resume from.
+		// The needle must already be lowercase and must not contain NUL.
+		template<class FUNC>
+		static void Scan(std::span<const char> a_arena, std::string_view a_needle, FUNC a_func, Path a_path = Utils::CpuFeatures::GetPath())
+		{
+			if (a_needle.empty() || a_needle.size() > a_arena.size())
+			{
+				return;
+			}
+
+			std::size_t pos{ 0 };
+			switch (a_path)
+			{
+				case Path::kAVX2:
+					pos = ScanAVX2(a_arena, a_needle, a_func);
+					break;
+				case Path::kSSE2:
+					pos = ScanSSE2(a_arena, a_needle, a_func);
+					break;
+				default:
+					break;
+			}
+
+			ScanScalar(a_arena, a_needle, a_func, pos);
+		}
+
+	private:
+		static char ToLower(char a_char) noexcept
+		{
+			return (a_char >= 'A' && a_char <= 'Z') ? static_cast<char>(a_char + ('a' - 'A')) : a_char;
+		}
+
+		static bool Matches(const char* a_name, std::string_view a_needle) noexcept
+		{
+			for (std::size_t i = 0; i < a_needle.size(); i++)
+			{
+				if (ToLower(a_name[i]) != a_needle[i])
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		template<class FUNC>
+		static void ScanScalar(std::span<const char> a_arena, std::string_view a_needle, FUNC& a_func, std::size_t a_pos)
+		{
+			auto last = a_arena.size() - a_needle.size();
+			while (a_pos <= last)
+			{
+				if (Matches(a_arena.data() + a_pos, a_needle))
+				{
+					a_pos = std::max<std::size_t>(a_func(a_pos), a_pos + 1);
+				}
+				else
+				{
+					a_pos++;
+				}
+			}
+		}
+
+		// Candidates are positions where both the first and last bytes of the needle match, the rest is checked per candidate.
+		// Returns where the scalar loop has to take over.
+		template<class FUNC>
+		static std::size_t ScanSSE2(std::span<const char> a_arena, std::string_view a_needle, FUNC& a_func)
+		{
+			constexpr std::size_t WIDTH = 16;
+
+			const auto data = a_arena.data();
+			const auto first = _mm_set1_epi8(a_needle.front());
+			const auto last = _mm_set1_epi8(a_needle.back());
+			const auto tail = a_needle.size() - 1;
+
+			// Shifts A-Z to the bottom of the signed range so one compare finds them
+			const auto shift = _mm_set1_epi8(0x80 - 'A');
+			const auto bound = _mm_set1_epi8(-0x80 + 26);
+			const auto flip = _mm_set1_epi8(0x20);
+			auto lower = [&](__m128i a_block)
+			{
+				auto upper = _mm_cmplt_epi8(_mm_add_epi8(a_block, shift), bound);
+				return _mm_or_si128(a_block, _mm_and_si128(upper, flip));
+			};
+
+			std::size_t pos{ 0 };
+			while (pos + tail + WIDTH <= a_arena.size())
+			{
+				auto blockFirst = lower(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos)));
+				auto blockLast = lower(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + tail)));
+				auto mask = static_cast<std::uint32_t>(
+					_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last))));
+				pos = ScanMask(data, a_needle, a_func, pos, mask, WIDTH);
+			}
+
+			return pos;
+		}
+
+		template<class FUNC>
+		static std::size_t ScanAVX2(std::span<const char> a_arena, std::string_view a_needle, FUNC& a_func)
+		{
+			constexpr std::size_t WIDTH = 32;
+
+			const auto data = a_arena.data();
+			const auto first = _mm256_set1_epi8(a_needle.front());
+			const auto last = _mm256_set1_epi8(a_needle.back());
+			const auto tail = a_needle.size() - 1;
+
+			const auto shift = _mm256_set1_epi8(0x80 - 'A');
+			const auto bound = _mm256_set1_epi8(-0x80 + 26);
+			const auto flip = _mm256_set1_epi8(0x20);
+			auto lower = [&](__m256i a_block)
+			{
+				auto upper = _mm256_cmpgt_epi8(bound, _mm256_add_epi8(a_block, shift));
+				return _mm256_or_si256(a_block, _mm256_and_si256(upper, flip));
+			};
+
+			std::size_t pos{ 0 };
+			while (pos + tail + WIDTH <= a_arena.size())
+			{
+				auto blockFirst = lower(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos)));
+				auto blockLast = lower(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + tail)));
+				auto mask = static_cast<std::uint32_t>(
+					_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last))));
+				pos = ScanMask(data, a_needle, a_func, pos, mask, WIDTH);
+			}
+
+			return pos;
+		}
+
+		// Returns the next block to load, which is further along if a match resumed past this one
+		template<class FUNC>
+		static std::size_t ScanMask(const char* a_data, std::string_view a_needle, FUNC& a_func, std::size_t a_pos, std::uint32_t a_mask, std::size_t a_width)
+		{
+			auto next = a_pos + a_width;
+			while (a_mask)
+			{
+				auto candidate = a_pos + std::countr_zero(a_mask);
+				if (!Matches(a_data + candidate, a_needle))
+				{
+					a_mask &= a_mask - 1;
+					continue;
+				}
+
+				auto resume = std::max<std::size_t>(a_func(candidate), candidate + 1);
+				if (resume >= next)
+				{
+					return resume;
+				}
+
+				a_mask &= ~std::uint32_t{ 0 } << (resume - a_pos);
+			}
+
+			return next;
+		}
+	};
+}
@@ -1,188 +1,739 @@
 #pragma once
+#include "FormIndex.h"
+#include "FormIndexCache.h"
+#include "FormIndexExport.h"
+#include "FormLabel.h"
+#include "FormSearch.h"
 
 namespace Menus
 {
 	class PluginExplorer
 	{
 	public:
-		class PluginInfo
+		using FormList = FormIndex::FormList;
+
+		// Full plugins are keyed by compile index, light plugins by 0xFE and their 12-bit light index, matching FormID prefixes
+		class PluginKey
 		{
 		public:
-			using FormMap = std::map<std::uint32_t, std::string_view>;
+			static constexpr std::uint32_t LIGHT_INDEX{ 0xFE };
+			static constexpr std::uint32_t FULL_SLOTS{ 0x100 };
+			static constexpr std::uint32_t LIGHT_SLOTS{ 0x1000 };
+			static constexpr std::uint32_t SLOT_COUNT{ FULL_SLOTS + LIGHT_SLOTS };
+
+			PluginKey() = default;
+
+			explicit PluginKey(const RE::TESFile* a_file) noexcept :
+				compileIndex(a_file->GetCompileIndex()),
+				lightIndex((a_file->GetCompileIndex() == LIGHT_INDEX) ? (a_file->GetSmallFileCompileIndex() & (LIGHT_SLOTS - 1)) : 0)
+			{}
+
+			[[nodiscard]] bool IsLight() const noexcept { return compileIndex == LIGHT_INDEX; }
+			[[nodiscard]] std::uint32_t GetCompileIndex() const noexcept { return compileIndex; }
+			[[nodiscard]] std::uint32_t GetLightIndex() const noexcept { return lightIndex; }
+			[[nodiscard]] std::uint32_t GetValue() const noexcept { return (compileIndex << 12) | lightIndex; }
+
+			// Index into a direct-indexed table of every possible plugin
+			[[nodiscard]] std::uint32_t GetSlot() const noexcept { return IsLight() ? FULL_SLOTS + lightIndex : compileIndex; }
+
+			[[nodiscard]] bool operator==(const PluginKey& a_rhs) const noexcept { return GetValue() == a_rhs.GetValue(); }
+
+		private:
+			std::uint32_t compileIndex{ 0 };
+			std::uint32_t lightIndex{ 0 };
+		};
 
-			PluginInfo(std::string_view a_name) :
+		class PluginInfo
+		{
+		public:
+			PluginInfo(const FormIndex* a_formIndex, std::uint32_t a_index, PluginKey a_key, std::string_view a_name) :
+				formIndex(a_formIndex),
+				index(a_index),
+				key(a_key),
 				name(a_name)
 			{}
 
-			template<class FORM_TYPE>
-			void AddForm(FORM_TYPE a_form)
-			{
-				auto formName = RE::TESFullName::GetFullName(*a_form);
-				if (!a_form->GetPlayable(nullptr) || formName.empty())
-				{
-					return;
-				}
+			[[nodiscard]] PluginKey GetKey() const noexcept { return key; }
+			[[nodiscard]] std::string_view GetName() const noexcept { return name; }
+			[[nodiscard]] FormList GetForms(FormCategory a_category) const noexcept { return formIndex->GetForms(index, a_category); }
+			[[nodiscard]] std::uint64_t GetCount() const noexcept { return formIndex->GetCount(index); }
 
-				switch (a_form->GetFormType())
-				{
-					case RE::ENUM_FORM_ID::kALCH:
-						{
-							mapALCH.insert_or_assign(a_form->GetFormID(), formName);
-							break;
-						}
-					case RE::ENUM_FORM_ID::kAMMO:
-						{
-							mapAMMO.insert_or_assign(a_form->GetFormID(), formName);
-							break;
-						}
-					case RE::ENUM_FORM_ID::kARMO:
-						{
-							mapARMO.insert_or_assign(a_form->GetFormID(), formName);
-							break;
-						}
-					case RE::ENUM_FORM_ID::kBOOK:
-						{
-							mapBOOK.insert_or_assign(a_form->GetFormID(), formName);
-							break;
-						}
-					case RE::ENUM_FORM_ID::kKEYM:
-						{
-							mapKEYS.insert_or_assign(a_form->GetFormID(), formName);
-							break;
-						}
-					case RE::ENUM_FORM_ID::kMISC:
-						{
-							mapMISC.insert_or_assign(a_form->GetFormID(), formName);
-							break;
-						}
-					case RE::ENUM_FORM_ID::kNOTE:
-						{
-							mapHOLO.insert_or_assign(a_form->GetFormID(), formName);
-							break;
-						}
-					case RE::ENUM_FORM_ID::kWEAP:
-						{
-							mapWEAP.insert_or_assign(a_form->GetFormID(), formName);
-							break;
-						}
-					default:
-						{
-							logger::warn(FMT_STRING("ModInfo::Add - Unhandled FormType: {:d}"), a_form->GetFormType());
-							break;
-						}
-				}
+		private:
+			const FormIndex* formIndex{ nullptr };
+			std::uint32_t index{ 0 };
+			PluginKey key;
+			std::string_view name{ "" };
+		};
+
+		class Snapshot
+		{
+		public:
+			explicit Snapshot(std::uint32_t a_generation) :
+				generation(a_generation)
+			{
+				liveSnapshots++;
 			}
 
-			[[nodiscard]] std::string_view GetName() const noexcept { return name; }
-			[[nodiscard]] FormMap GetMapALCH() const noexcept { return mapALCH; }
-			[[nodiscard]] FormMap GetMapAMMO() const noexcept { return mapAMMO; }
-			[[nodiscard]] FormMap GetMapARMO() const noexcept { return mapARMO; }
-			[[nodiscard]] FormMap GetMapBOOK() const noexcept { return mapBOOK; }
-			[[nodiscard]] FormMap GetMapHOLO() const noexcept { return mapHOLO; }
-			[[nodiscard]] FormMap GetMapKEYS() const noexcept { return mapKEYS; }
-			[[nodiscard]] FormMap GetMapMISC() const noexcept { return mapMISC; }
-			[[nodiscard]] FormMap GetMapWEAP() const noexcept { return mapWEAP; }
-
-			[[nodiscard]] std::uint64_t GetCount() const noexcept
-			{
-				std::uint64_t result{ 0 };
-				result += mapALCH.size();
-				result += mapAMMO.size();
-				result += mapARMO.size();
-				result += mapBOOK.size();
-				result += mapHOLO.size();
-				result += mapKEYS.size();
-				result += mapMISC.size();
-				result += mapWEAP.size();
-				return result;
+			Snapshot(const Snapshot&) = delete;
+			Snapshot& operator=(const Snapshot&) = delete;
+
+			~Snapshot()
+			{
+				liveSnapshots--;
+				liveBytes -= byteSize;
 			}
 
+			[[nodiscard]] std::span<const PluginInfo> GetPluginList() const noexcept { return pluginList; }
+			[[nodiscard]] const FormIndex& GetFormIndex() const noexcept { return formIndex; }
+			[[nodiscard]] const FormSearch& GetFormSearch() const noexcept { return formSearch; }
+			[[nodiscard]] std::uint32_t GetGeneration() const noexcept { return generation; }
+			[[nodiscard]] std::size_t GetByteSize() const noexcept { return byteSize; }
+			[[nodiscard]] bool IsComplete() const noexcept { return complete; }
+
 		private:
-			std::string_view name{ "" };
-			FormMap mapALCH;
-			FormMap mapAMMO;
-			FormMap mapARMO;
-			FormMap mapBOOK;
-			FormMap mapHOLO;
-			FormMap mapKEYS;
-			FormMap mapMISC;
-			FormMap mapWEAP;
+			friend class PluginExplorer;
+
+			// Everything a snapshot owns is released with it, so live bytes only count published snapshots still held somewhere
+			void UpdateByteSize()
+			{
+				auto size = sizeof(Snapshot) + pluginList.capacity() * sizeof(PluginInfo) + formIndex.GetByteSize() + formSearch.GetByteSize();
+				liveBytes += size;
+				liveBytes -= byteSize;
+				byteSize = size;
+			}
+
+			std::vector<PluginInfo> pluginList;
+			FormIndex formIndex;
+			FormSearch formSearch;
+			std::uint32_t generation{ 0 };
+			std::size_t byteSize{ 0 };
+			bool complete{ false };
 		};
 
-		using PluginList = std::vector<std::pair<std::uint32_t, PluginInfo>>;
+		// kNone until Initialize and again after Reset, kFailed when the build stopped on an error. Neither publishes
+		// anything more, so only kBuilding is worth waiting on.
+		enum class State : std::uint32_t
+		{
+			kNone,
+			kBuilding,
+			kReady,
+			kFailed
+		};
+
+		static constexpr std::array<std::string_view, 4> STATE_NAMES{ "None"sv, "Building"sv, "Ready"sv, "Failed"sv };
+
+		struct Stats
+		{
+			State state{ State::kNone };
+			std::uint32_t generation{ 0 };
+			std::size_t liveSnapshots{ 0 };
+			std::size_t liveBytes{ 0 };
+			std::size_t formCount{ 0 };
+			std::size_t pluginCount{ 0 };
+			bool complete{ false };
+		};
 
 		static void Initialize()
 		{
+			Reset();
+
 			auto TESDataHandler = RE::TESDataHandler::GetSingleton();
 			if (!TESDataHandler)
 			{
 				logger::error("Missing TESDataHandler!"sv);
+				state = State::kFailed;
 				return;
 			}
 
-			auto pluginCount = 0;
-			for (auto file : TESDataHandler->files)
+			// Publish the plugin list straight away, forms follow once the build finishes
+			auto current = ++generation;
+			auto partial = std::make_shared<Snapshot>(current);
+			AddPlugins(*partial, nullptr);
+			partial->UpdateByteSize();
+			snapshot.store(std::move(partial));
+
+			// The load order and form arrays belong to the game, so they are copied here, on its thread, together with
+			// each form's name. The build only reads plain fields of the forms, which stay put until Reset has stopped it.
+			auto result = std::make_shared<Snapshot>(current);
+			auto ingestor = std::make_unique<Ingestor>();
+			auto pluginCount = AddPlugins(*result, ingestor.get());
+			auto sources = Utils::Fingerprint::Sources::Capture();
+			FormRegistry::ForEach(
+				[&]<class CATEGORY>()
+				{
+					if constexpr (!std::is_void_v<typename CATEGORY::form_type>)
+					{
+						ingestor->AddForms<CATEGORY>();
+					}
+				});
+
+			state = State::kBuilding;
+			buildThread = std::jthread(
+				[result = std::move(result), ingestor = std::move(ingestor), pluginCount, sources = std::move(sources)](std::stop_token a_stop) mutable
+				{
+					try
+					{
+						Build(a_stop, std::move(result), *ingestor, pluginCount, sources);
+					}
+					catch (const std::exception& e)
+					{
+						logger::error(FMT_STRING("PluginExplorer: Index build failed: {:s}"), e.what());
+						state = State::kFailed;
+					}
+				});
+		}
+
+		static void Reset()
+		{
+			if (buildThread.joinable())
+			{
+				buildThread.request_stop();
+				buildThread.join();
+			}
+
+			snapshot.store(nullptr);
+			state = State::kNone;
+			tasksCompleted = 0;
+			tasksTotal = 0;
+
+			// Anything still live here is held by an open menu and goes once it closes
+			logger::debug(
+				FMT_STRING("PluginExplorer: Reset generation {:d} ({:d} snapshots, {:d} bytes still live)"),
+				generation.load(),
+				liveSnapshots.load(),
+				liveBytes.load());
+		}
+
+		static std::shared_ptr<const Snapshot> GetSnapshot() noexcept { return snapshot.load(); }
+		static State GetState() noexcept { return state.load(); }
+
+		static bool IsReady() noexcept
+		{
+			auto current = snapshot.load();
+			return current && current->IsComplete();
+		}
+
+		static Stats GetStats() noexcept
+		{
+			Stats result;
+			result.state = state.load();
+			result.generation = generation.load();
+			result.liveSnapshots = liveSnapshots.load();
+			result.liveBytes = liveBytes.load();
+			if (auto current = snapshot.load(); current)
+			{
+				result.formCount = current->GetFormIndex().GetFormCount();
+				result.pluginCount = current->GetPluginList().size();
+				result.complete = current->IsComplete();
+			}
+
+			return result;
+		}
+
+		static std::filesystem::path GetExportPath(FormIndexExport::Format a_format)
+		{
+			return fmt::format(
+				FMT_STRING("Data/F4SE/Plugins/{}_PluginExplorer{}"),
+				Version::PROJECT,
+				FormIndexExport::FORMAT_EXTENSIONS[stl::to_underlying(a_format)]);
+		}
+
+		// Writes a complete snapshot out for offline auditing, returns the number of forms written
+		static std::optional<std::uint64_t> Export(const Snapshot& a_snapshot, FormIndexExport::Format a_format)
+		{
+			if (!a_snapshot.IsComplete())
+			{
+				return std::nullopt;
+			}
+
+			std::vector<std::string_view> plugins;
+			plugins.reserve(a_snapshot.GetPluginList().size());
+			for (auto& plugin : a_snapshot.GetPluginList())
+			{
+				plugins.push_back(plugin.GetName());
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			auto path = GetExportPath(a_format);
+			auto count = FormIndexExport::Export(path, a_snapshot.GetFormIndex(), plugins, a_format);
+			if (!count)
+			{
+				logger::warn(FMT_STRING("PluginExplorer: Failed to export index to {:s}"), path.string());
+				return std::nullopt;
+			}
+
+			auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+			std::error_code ec;
+			logger::debug(
+				FMT_STRING("PluginExplorer: Exported {:d} forms as {:s} in {:d}us ({:d} bytes)"),
+				*count,
+				FormIndexExport::FORMAT_NAMES[stl::to_underlying(a_format)],
+				elapsed.count(),
+				std::filesystem::file_size(path, ec));
+			return count;
+		}
+
+		static float GetProgress() noexcept
+		{
+			auto total = tasksTotal.load();
+			return total ? static_cast<float>(tasksCompleted.load()) / total : 0.0F;
+		}
+
+	private:
+		class Ingestor;
+
+		static std::uint32_t AddPlugins(Snapshot& a_snapshot, Ingestor* a_ingestor)
+		{
+			std::uint32_t pluginCount = 0;
+			for (auto file : RE::TESDataHandler::GetSingleton()->files)
 			{
 				if (file->IsActive())
 				{
-					auto combinedIndex = GetCombinedIndex(file);
-					modMap.insert_or_assign(combinedIndex, file->GetFilename());
-					idxMap.insert_or_assign(pluginCount++, combinedIndex);
+					if (a_ingestor)
+					{
+						a_ingestor->AddPlugin(file, pluginCount);
+					}
+
+					a_snapshot.pluginList.emplace_back(&a_snapshot.formIndex, pluginCount++, PluginKey{ file }, file->GetFilename());
 				}
 			}
 
-			AddForms<RE::AlchemyItem>();
-			AddForms<RE::BGSNote>();
-			AddForms<RE::TESAmmo>();
-			AddForms<RE::TESKey>();
-			AddForms<RE::TESObjectARMO>();
-			AddForms<RE::TESObjectBOOK>();
-			AddForms<RE::TESObjectMISC>();
-			AddForms<RE::TESObjectWEAP>();
+			return pluginCount;
+		}
+
+		static void Build(std::stop_token a_stop, std::shared_ptr<Snapshot> a_result, Ingestor& a_ingestor, std::uint32_t a_pluginCount, const Utils::Fingerprint::Sources& a_sources)
+		{
+			auto start = std::chrono::steady_clock::now();
+			auto result = std::move(a_result);
+			auto useCache = *Settings::EnableExplorerIndexCache;
+			auto fingerprint = useCache ? GetFingerprint(a_sources) : 0;
+			auto cachePath = GetCachePath(fingerprint);
 
-			for (auto& index : idxMap)
+			if (useCache)
 			{
-				auto info = modMap.find(index.second);
-				if (info != modMap.end())
+				RemoveStaleCaches(cachePath);
+				if (auto cached = FormIndexCache::Load(cachePath, fingerprint); cached && cached->GetPluginCount() == a_pluginCount)
 				{
-					pluginList.emplace_back(info->first, info->second);
+					result->formIndex = std::move(*cached);
+					LogIndex("Mapped"sv, result->formIndex, start);
+					Publish(std::move(result));
+					return;
 				}
 			}
+
+			result->formIndex = a_ingestor.Build(a_pluginCount, GetThreadCount(), a_stop);
+
+			if (a_stop.stop_requested())
+			{
+				logger::debug("PluginExplorer: Index build cancelled."sv);
+				return;
+			}
+
+			LogIndex("Built"sv, result->formIndex, start);
+			Publish(result);
+
+			if (useCache && !FormIndexCache::Save(cachePath, result->formIndex, fingerprint))
+			{
+				logger::warn("PluginExplorer: Failed to write index cache."sv);
+			}
 		}
 
-		static void Reset()
+		// The search index is derived from the form index, so it is rebuilt rather than cached
+		static void Publish(std::shared_ptr<Snapshot> a_result)
 		{
-			pluginList.clear();
+			auto start = std::chrono::steady_clock::now();
+			a_result->formSearch = FormSearch{ std::addressof(a_result->formIndex) };
+			a_result->complete = true;
+			a_result->UpdateByteSize();
+
+			auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+			logger::debug(
+				FMT_STRING("PluginExplorer: Built search index of {:d} trigrams in {:d}us ({:d} bytes, {:s} scanner)"),
+				a_result->formSearch.GetTrigramCount(),
+				elapsed.count(),
+				a_result->formSearch.GetByteSize(),
+				Utils::CpuFeatures::GetPathName(Utils::CpuFeatures::GetPath()));
+			snapshot.store(std::move(a_result));
+			state = State::kReady;
 		}
 
-		static PluginList GetPluginList() noexcept { return pluginList; }
+		static void LogIndex(std::string_view a_action, const FormIndex& a_formIndex, std::chrono::steady_clock::time_point a_start)
+		{
+			auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - a_start);
+			auto formCount = a_formIndex.GetFormCount();
+			auto byteSize = a_formIndex.GetByteSize();
+			logger::debug(
+				FMT_STRING("PluginExplorer: {:s} index of {:d} forms from {:d} plugins in {:d}us ({:d} bytes, {:.1f} bytes/form)"),
+				a_action,
+				formCount,
+				a_formIndex.GetPluginCount(),
+				elapsed.count(),
+				byteSize,
+				formCount ? static_cast<double>(byteSize) / formCount : 0.0);
+		}
 
-	private:
-		static std::uint32_t GetCombinedIndex(const RE::TESFile* a_file)
+		// Each load order gets a file of its own. A snapshot from an earlier load can still have its cache mapped, and
+		// Windows will not replace a mapped file, so a changed index is never written over one.
+		static std::filesystem::path GetCachePath(std::uint64_t a_fingerprint)
 		{
-			return static_cast<std::uint32_t>(a_file->GetCompileIndex() + a_file->GetSmallFileCompileIndex());
+			return fmt::format(FMT_STRING("Data/F4SE/Plugins/{}_PluginExplorer.{:016X}.cache"), Version::PROJECT, a_fingerprint);
 		}
 
-		template<class FORM_TYPE>
-		static void AddForms()
+		// Caches of other load orders, and the unversioned one older builds wrote, are removed as each build starts.
+		// One still mapped fails to go and is left for a later build.
+		static void RemoveStaleCaches(const std::filesystem::path& a_keep)
 		{
-			auto TESDataHandler = RE::TESDataHandler::GetSingleton();
-			for (auto form : TESDataHandler->GetFormArray<FORM_TYPE>())
+			auto prefix = fmt::format(FMT_STRING("{}_PluginExplorer."), Version::PROJECT);
+			auto keep = a_keep.filename().string();
+
+			std::error_code ec;
+			std::filesystem::directory_iterator iter{ a_keep.parent_path(), ec };
+			for (; !ec && iter != std::filesystem::directory_iterator{}; iter.increment(ec))
 			{
-				auto file = form->GetFile(0);
-				if (file && file->compileIndex < 0xFF)
+				auto name = iter->path().filename().string();
+				if (name != keep && name.starts_with(prefix) && (name.ends_with(".cache"sv) || name.ends_with(".cache.tmp"sv)))
 				{
-					auto info = modMap.find(GetCombinedIndex(file));
-					if (info != modMap.end())
+					std::error_code removeError;
+					if (std::filesystem::remove(iter->path(), removeError))
 					{
-						info->second.AddForm(form);
+						logger::debug(FMT_STRING("PluginExplorer: Removed stale index cache {:s}"), name);
 					}
 				}
 			}
 		}
 
-		static inline std::map<std::uint32_t, PluginInfo> modMap;
-		static inline std::map<std::uint32_t, std::uint32_t> idxMap;
-		static inline PluginList pluginList;
+		// Any change to the active files, their order or their contents, the language or the string tables
+		// invalidates the cache
+		static std::uint64_t GetFingerprint(const Utils::Fingerprint::Sources& a_sources)
+		{
+			Utils::Fingerprint fingerprint;
+			fingerprint.Add(std::uint64_t{ FormIndex::VERSION });
+			fingerprint.AddLoadOrder(a_sources);
+			fingerprint.AddStrings(a_sources);
+			return fingerprint.Get();
+		}
+
+		static std::size_t GetThreadCount()
+		{
+			auto threadCount = *Settings::ExplorerIndexThreads;
+			if (threadCount > 0)
+			{
+				return static_cast<std::size_t>(threadCount);
+			}
+
+			return std::max(std::thread::hardware_concurrency(), 1u);
+		}
+
+		class Ingestor
+		{
+		public:
+			static constexpr std::uint32_t INVALID_PLUGIN{ static_cast<std::uint32_t>(-1) };
+
+			Ingestor()
+			{
+				slots.fill(INVALID_PLUGIN);
+			}
+
+			void AddPlugin(const RE::TESFile* a_file, std::uint32_t a_plugin)
+			{
+				slots[PluginKey{ a_file }.GetSlot()] = a_plugin;
+			}
+
+			// Copies the form array, so tasks never read the game's own while it may be growing. The playable flag and
+			// names come from the game's virtuals and are read here on its thread too, tasks only get the forms that
+			// pass with a view of their name, which stays put like the form itself.
+			template<class CATEGORY>
+			void AddForms()
+			{
+				using form_type = typename CATEGORY::form_type;
+				constexpr auto category = FormRegistry::Get<CATEGORY>();
+				auto& array = RE::TESDataHandler::GetSingleton()->GetFormArray<form_type>();
+				auto records = std::make_shared<std::vector<Record<form_type>>>();
+				records->reserve(array.size());
+				for (auto form : array)
+				{
+					if constexpr (!requires { CATEGORY::SKIP_PLAYABLE; })
+					{
+						if (!form->GetPlayable(nullptr))
+						{
+							continue;
+						}
+					}
+
+					auto formName = GetName<CATEGORY>(form);
+					if (!formName.empty() || requires { CATEGORY::USE_EDITOR_ID; })
+					{
+						records->push_back({ form, formName });
+					}
+				}
+
+				builder.Reserve(category, records->size());
+				totals[stl::to_underlying(category)] += array.size();
+
+				for (std::size_t begin = 0; begin < records->size(); begin += CHUNK_SIZE)
+				{
+					auto end = std::min<std::size_t>(begin + CHUNK_SIZE, records->size());
+					tasks.push_back(
+						{ category,
+						  [this, records, begin, end](FormIndex::Builder& a_shard)
+						  {
+							  std::size_t count{ 0 };
+							  std::vector<std::uint32_t> overrides;
+							  for (auto i = begin; i < end; i++)
+							  {
+								  if (AddForm<CATEGORY>(a_shard, (*records)[i], overrides))
+								  {
+									  count++;
+								  }
+							  }
+
+							  return count;
+						  } });
+				}
+			}
+
+			[[nodiscard]] FormIndex Build(std::size_t a_pluginCount, std::size_t a_threadCount, std::stop_token a_stop)
+			{
+				// Merging and sorting the categories count as one final task
+				tasksTotal = tasks.size() + 1;
+
+				std::vector<FormIndex::Builder> shards(tasks.size());
+				std::vector<TaskResult> results(tasks.size());
+				RunParallel(
+					tasks.size(),
+					a_threadCount,
+					[&](std::size_t a_task)
+					{
+						if (a_stop.stop_requested())
+						{
+							return;
+						}
+
+						auto start = std::chrono::steady_clock::now();
+						results[a_task].count = tasks[a_task].func(shards[a_task]);
+						for (std::uint32_t category = 0; category < FormIndex::CATEGORY_COUNT; category++)
+						{
+							shards[a_task].Sort(static_cast<FormCategory>(category));
+						}
+
+						results[a_task].elapsed = std::chrono::steady_clock::now() - start;
+						tasksCompleted++;
+					});
+
+				if (a_stop.stop_requested())
+				{
+					return {};
+				}
+
+				// Shards are merged in task order, so the result matches a serial build exactly
+				std::array<std::size_t, FormIndex::CATEGORY_COUNT> counts{};
+				std::array<std::chrono::steady_clock::duration, FormIndex::CATEGORY_COUNT> times{};
+				for (std::size_t i = 0; i < tasks.size(); i++)
+				{
+					auto category = stl::to_underlying(tasks[i].category);
+					counts[category] += results[i].count;
+					times[category] += results[i].elapsed;
+					builder.Merge(std::move(shards[i]));
+				}
+
+				RunParallel(
+					FormIndex::CATEGORY_COUNT,
+					a_threadCount,
+					[&](std::size_t a_category)
+					{
+						builder.Sort(static_cast<FormCategory>(a_category));
+					});
+
+				// Forms are counted under the category they were read as, not the one they were split into
+				for (std::uint32_t category = 0; category < FormIndex::CATEGORY_COUNT; category++)
+				{
+					if (totals[category] == 0)
+					{
+						continue;
+					}
+
+					logger::debug(
+						FMT_STRING("PluginExplorer: Ingested {:d}/{:d} {:s} forms in {:d}us"),
+						counts[category],
+						totals[category],
+						FormIndex::CATEGORY_NAMES[category],
+						std::chrono::duration_cast<std::chrono::microseconds>(times[category]).count());
+				}
+
+				auto result = builder.Build(a_pluginCount);
+				tasksCompleted++;
+				return result;
+			}
+
+		private:
+			static constexpr std::size_t CHUNK_SIZE{ 0x4000 };
+
+			struct Task
+			{
+				FormCategory category;
+				std::function<std::size_t(FormIndex::Builder&)> func;
+			};
+
+			struct TaskResult
+			{
+				std::size_t count{ 0 };
+				std::chrono::steady_clock::duration elapsed{};
+			};
+
+			template<class T>
+			struct Record
+			{
+				T* form;
+				std::string_view name;
+			};
+
+			// The first exception thrown by any worker stops the rest and is rethrown here once they have all finished
+			template<class FUNC>
+			static void RunParallel(std::size_t a_count, std::size_t a_threadCount, FUNC a_func)
+			{
+				std::atomic<std::size_t> next{ 0 };
+				std::mutex errorLock;
+				std::exception_ptr error;
+				auto Worker = [&]()
+				{
+					try
+					{
+						for (auto i = next++; i < a_count; i = next++)
+						{
+							a_func(i);
+						}
+					}
+					catch (...)
+					{
+						next = a_count;
+						std::scoped_lock lock{ errorLock };
+						if (!error)
+						{
+							error = std::current_exception();
+						}
+					}
+				};
+
+				auto workerCount = std::min(std::max<std::size_t>(a_threadCount, 1), a_count);
+				std::vector<std::jthread> workers;
+				for (std::size_t i = 1; i < workerCount; i++)
+				{
+					workers.emplace_back(Worker);
+				}
+
+				Worker();
+				workers.clear();
+				if (error)
+				{
+					std::rethrow_exception(error);
+				}
+			}
+
+			// The game strips most editor IDs at runtime, forms without one are listed by plugin and FormID label
+			template<class CATEGORY>
+			static std::string_view GetName(const typename CATEGORY::form_type* a_form)
+			{
+				std::string_view formName = RE::TESFullName::GetFullName(*a_form);
+				if constexpr (requires { CATEGORY::USE_EDITOR_ID; })
+				{
+					if (auto editorID = a_form->GetFormEditorID(); formName.empty() && editorID)
+					{
+						formName = editorID;
+					}
+				}
+
+				return formName;
+			}
+
+			template<class CATEGORY>
+			bool AddForm(FormIndex::Builder& a_shard, const Record<typename CATEGORY::form_type>& a_record, std::vector<std::uint32_t>& a_overrides) const
+			{
+				auto form = a_record.form;
+				auto file = form->GetFile(0);
+				if (!file)
+				{
+					return false;
+				}
+
+				auto plugin = slots[PluginKey{ file }.GetSlot()];
+				if (plugin == INVALID_PLUGIN)
+				{
+					return false;
+				}
+
+				auto category = FormRegistry::Get<CATEGORY>();
+				if constexpr (requires { CATEGORY::Classify(form); })
+				{
+					category = CATEGORY::Classify(form);
+				}
+
+				// Every file after the first overrides the form, in load order
+				a_overrides.clear();
+				if (auto files = form->sourceFiles.array; files)
+				{
+					for (std::uint32_t i = 1; i < files->size(); i++)
+					{
+						if (auto overrider = slots[PluginKey{ (*files)[i] }.GetSlot()]; overrider != INVALID_PLUGIN && overrider != plugin)
+						{
+							a_overrides.push_back(overrider);
+						}
+					}
+				}
+
+				auto formID = form->GetFormID();
+				if (!a_record.name.empty())
+				{
+					a_shard.Add(category, plugin, formID, a_record.name, GetStats<CATEGORY>(form), a_overrides);
+				}
+				else
+				{
+					// Only categories listed by editor ID pass a form without a name. A bare FormID label reads the
+					// same for every plugin, so the plugin's file name goes first, as in "Fallout4.esm [0001C3F5]".
+					a_shard.AddOwned(category, plugin, formID, { file->GetFilename(), " "sv, FormLabel::FormID(formID).view() }, GetStats<CATEGORY>(form), a_overrides);
+				}
+
+				return true;
+			}
+
+			template<class CATEGORY>
+			static FormStats GetStats(const typename CATEGORY::form_type* a_form)
+			{
+				using form_type = typename CATEGORY::form_type;
+				if constexpr (requires { CATEGORY::GetStats(a_form); })
+				{
+					return CATEGORY::GetStats(a_form);
+				}
+				else
+				{
+					FormStats result;
+					result.fill(std::numeric_limits<float>::quiet_NaN());
+					if constexpr (std::is_base_of_v<RE::TESValueForm, form_type>)
+					{
+						result[stl::to_underlying(FormStat::kValue)] = static_cast<float>(static_cast<const RE::TESValueForm*>(a_form)->value);
+					}
+
+					if constexpr (std::is_base_of_v<RE::TESWeightForm, form_type>)
+					{
+						result[stl::to_underlying(FormStat::kWeight)] = static_cast<const RE::TESWeightForm*>(a_form)->weight;
+					}
+
+					return result;
+				}
+			}
+
+			std::array<std::uint32_t, PluginKey::SLOT_COUNT> slots;
+			std::array<std::size_t, FormIndex::CATEGORY_COUNT> totals{};
+			std::vector<Task> tasks;
+			FormIndex::Builder builder;
+		};
+
+		static inline std::atomic<std::uint32_t> generation{ 0 };
+		static inline std::atomic<std::size_t> liveSnapshots{ 0 };
+		static inline std::atomic<std::size_t> liveBytes{ 0 };
+		static inline std::atomic<std::shared_ptr<const Snapshot>> snapshot;
+		static inline std::atomic<State> state{ State::kNone };
+		static inline std::atomic<std::size_t> tasksCompleted{ 0 };
+		static inline std::atomic<std::size_t> tasksTotal{ 0 };
+		static inline std::jthread buildThread;
 	};
 }
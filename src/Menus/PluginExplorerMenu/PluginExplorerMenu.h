@@ -1,6 +1,8 @@
 #pragma once
 #include "Forms\Forms.h"
 #include "Menus\Utils\Utils.h"
+#include "FormLabel.h"
+#include "FormQuery.h"
 #include "PluginExplorer.h"
 
 namespace Menus
@@ -99,7 +101,8 @@ namespace Menus
 				case 5:
 					if ((a_params.argCount == 2) && a_params.args[0].IsUInt() && a_params.args[1].IsInt())
 					{
-						auto object = RE::TESForm::GetFormByID(a_params.args[0].GetUInt())->As<RE::TESBoundObject>();
+						auto form = RE::TESForm::GetFormByID(a_params.args[0].GetUInt());
+						auto object = (form && FormRegistry::IsInventoryType(form->GetFormType())) ? form->As<RE::TESBoundObject>() : nullptr;
 						if (object)
 						{
 							auto PlayerCharacter = RE::PlayerCharacter::GetSingleton();
@@ -108,6 +111,52 @@ namespace Menus
 					}
 					break;
 
+				case 6:
+					if ((a_params.argCount == 2) && a_params.args[0].IsUInt() && a_params.args[1].IsString())
+					{
+						GetPluginForms(a_params.args[0].GetUInt(), a_params.args[1].GetString());
+					}
+					break;
+
+				case 7:
+					if ((a_params.argCount == 2) && a_params.args[0].IsString() && a_params.args[1].IsUInt())
+					{
+						SearchForms(a_params.args[0].GetString(), a_params.args[1].GetUInt());
+					}
+					break;
+
+				case 8:
+					if ((a_params.argCount == 1) && a_params.args[0].IsArray())
+					{
+						AddItems(a_params.args[0]);
+					}
+					break;
+
+				case 9:
+					GetIndexStats();
+					break;
+
+				case 10:
+					if ((a_params.argCount == 3) && a_params.args[0].IsUInt() && a_params.args[1].IsString() && a_params.args[2].IsUInt())
+					{
+						GetFormOverrides(a_params.args[0].GetUInt(), a_params.args[1].GetString(), a_params.args[2].GetUInt());
+					}
+					break;
+
+				case 11:
+					if ((a_params.argCount == 3) && a_params.args[0].IsString() && a_params.args[1].IsArray() && a_params.args[2].IsUInt())
+					{
+						QueryForms(a_params.args[0].GetString(), a_params.args[1], a_params.args[2].GetUInt());
+					}
+					break;
+
+				case 12:
+					if ((a_params.argCount == 1) && a_params.args[0].IsString())
+					{
+						ExportIndex(a_params.args[0].GetString());
+					}
+					break;
+
 				default:
 					break;
 			}
@@ -121,6 +170,38 @@ namespace Menus
 			MapCodeMethodToASFunction("InitPluginList", 3);
 			MapCodeMethodToASFunction("SetTextEntry", 4);
 			MapCodeMethodToASFunction("AddItem", 5);
+			MapCodeMethodToASFunction("GetPluginForms", 6);
+			MapCodeMethodToASFunction("SearchForms", 7);
+			MapCodeMethodToASFunction("AddItems", 8);
+			MapCodeMethodToASFunction("GetIndexStats", 9);
+			MapCodeMethodToASFunction("GetFormOverrides", 10);
+			MapCodeMethodToASFunction("QueryForms", 11);
+			MapCodeMethodToASFunction("ExportIndex", 12);
+		}
+
+		virtual void AdvanceMovie(float a_timeDelta, std::uint64_t a_time) override
+		{
+			if (WaitingForIndex)
+			{
+				switch (PluginExplorer::GetState())
+				{
+					case PluginExplorer::State::kReady:
+						InitPluginList();
+						break;
+
+					case PluginExplorer::State::kBuilding:
+						UpdateLoadingProgress();
+						break;
+
+					default:
+						// The build failed or was reset, so no snapshot is coming
+						WaitingForIndex = false;
+						UpdateIndexState();
+						break;
+				}
+			}
+
+			RE::GameMenuBase::AdvanceMovie(a_timeDelta, a_time);
 		}
 
 		virtual void HandleEvent(const RE::ButtonEvent* a_event) override
@@ -206,6 +287,8 @@ namespace Menus
 		}
 
 	private:
+		static constexpr std::size_t SEARCH_PAGE_SIZE{ 100 };
+
 		void CloseMenu()
 		{
 			auto UIMessageQueue = RE::UIMessageQueue::GetSingleton();
@@ -228,100 +311,449 @@ namespace Menus
 			RE::Scaleform::GFx::Value PluginList[1];
 			uiMovie->CreateArray(&PluginList[0]);
 
-			for (auto& iter : PluginExplorer::GetPluginList())
+			// Until the index is ready, list every plugin without forms and keep polling while it is still building
+			snapshot = PluginExplorer::GetSnapshot();
+			WaitingForIndex = (!snapshot || !snapshot->IsComplete()) && PluginExplorer::GetState() == PluginExplorer::State::kBuilding;
+			PluginForms.clear();
+			SearchResults.Clear();
+			if (!snapshot)
 			{
-				if (iter.second.GetCount() == 0)
+				menuObj.Invoke("SetPluginList", nullptr, PluginList, 1);
+				UpdateIndexState();
+				return;
+			}
+
+			// Only names and counts are sent here, forms are sent per category by GetPluginForms
+			auto pluginList = snapshot->GetPluginList();
+			for (std::uint32_t i = 0; i < pluginList.size(); i++)
+			{
+				auto& plugin = pluginList[i];
+				if (snapshot->IsComplete() && plugin.GetCount() == 0)
 				{
 					continue;
 				}
 
-				auto ProcessForms = [&](RE::Scaleform::GFx::Value& a_value, const PluginExplorer::PluginInfo::FormMap a_map)
+				RE::Scaleform::GFx::Value counts;
+				uiMovie->CreateObject(&counts);
+				for (std::uint32_t category = 0; category < FormIndex::CATEGORY_COUNT; category++)
 				{
-					uiMovie->CreateArray(&a_value);
-					for (auto& entry : a_map)
+					counts.SetMember(
+						FormIndex::CATEGORY_NAMES[category].data(),
+						plugin.GetForms(static_cast<FormCategory>(category)).size());
+				}
+
+				auto key = plugin.GetKey();
+				auto pluginIndex = FormLabel::Plugin(key.GetCompileIndex(), key.GetLightIndex());
+
+				RE::Scaleform::GFx::Value listEntry;
+				uiMovie->CreateObject(&listEntry);
+				listEntry.SetMember("text", plugin.GetName().data());
+				listEntry.SetMember("textFormID", pluginIndex.c_str());
+				listEntry.SetMember("PluginIndex", i);
+				listEntry.SetMember("Counts", counts);
+				PluginList[0].PushBack(listEntry);
+			}
+
+			menuObj.Invoke("SetPluginList", nullptr, PluginList, 1);
+			UpdateLoadingProgress();
+			UpdateIndexState();
+		}
+
+		void GetPluginForms(std::uint32_t a_plugin, std::string_view a_category)
+		{
+			if (!snapshot || a_plugin >= snapshot->GetPluginList().size())
+			{
+				return;
+			}
+
+			auto iter = PluginForms.find({ a_plugin, std::string{ a_category } });
+			if (iter == PluginForms.end())
+			{
+				auto& names = FormIndex::CATEGORY_NAMES;
+				auto name = std::find(names.begin(), names.end(), a_category);
+				if (name == names.end())
+				{
+					return;
+				}
+
+				auto& plugin = snapshot->GetPluginList()[a_plugin];
+				RE::Scaleform::GFx::Value forms;
+				ProcessForms(forms, a_plugin, plugin.GetForms(static_cast<FormCategory>(name - names.begin())));
+				PluginForms.insert_or_assign({ a_plugin, std::string{ a_category } }, forms);
+
+				iter = PluginForms.find({ a_plugin, std::string{ a_category } });
+			}
+
+			RE::Scaleform::GFx::Value args[3];
+			args[0] = a_plugin;
+			args[1] = iter->first.second.c_str();
+			args[2] = iter->second;
+			menuObj.Invoke("SetPluginForms", nullptr, args, 3);
+		}
+
+		// Results are ranked natively and sent a page at a time, typing more of a query refines the last results
+		void SearchForms(std::string_view a_query, std::uint32_t a_page)
+		{
+			RE::Scaleform::GFx::Value args[4];
+			args[0] = a_query.data();
+			args[1] = a_page;
+			uiMovie->CreateArray(&args[3]);
+
+			// Nothing is searchable before the index is ready, but the movie still gets an empty page back
+			if (!snapshot || !snapshot->IsComplete())
+			{
+				args[2] = 0u;
+				menuObj.Invoke("SetSearchResults", nullptr, args, 4);
+				return;
+			}
+
+			auto& formSearch = snapshot->GetFormSearch();
+			formSearch.Search(a_query, SearchResults);
+			args[2] = static_cast<std::uint32_t>(SearchResults.GetCount());
+			for (auto entry : SearchResults.GetRanked(std::size_t{ a_page } * SEARCH_PAGE_SIZE, SEARCH_PAGE_SIZE))
+			{
+				auto formID = formSearch.GetFormID(entry);
+				auto textFormID = FormLabel::FormID(formID);
+
+				RE::Scaleform::GFx::Value listEntry;
+				uiMovie->CreateObject(&listEntry);
+				listEntry.SetMember("text", formSearch.GetName(entry).data());
+				listEntry.SetMember("textFormID", textFormID.c_str());
+				listEntry.SetMember("FormID", formID);
+				listEntry.SetMember("PluginIndex", formSearch.GetPlugin(entry));
+				listEntry.SetMember("Category", FormIndex::CATEGORY_NAMES[stl::to_underlying(formSearch.GetCategory(entry))].data());
+				args[3].PushBack(listEntry);
+			}
+
+			menuObj.Invoke("SetSearchResults", nullptr, args, 4);
+		}
+
+		// Takes an array of { FormID, Count } objects, resolves them all first and then reports the whole batch once
+		void AddItems(const RE::Scaleform::GFx::Value& a_items)
+		{
+			std::vector<std::pair<std::uint32_t, std::int32_t>> requests;
+			requests.reserve(a_items.GetArraySize());
+			for (std::uint32_t i = 0; i < a_items.GetArraySize(); i++)
+			{
+				RE::Scaleform::GFx::Value item, formID, count;
+				if (a_items.GetElement(i, &item) && item.IsObject() &&
+					item.GetMember("FormID", &formID) && formID.IsUInt() &&
+					item.GetMember("Count", &count) && count.IsInt() && count.GetInt() > 0)
+				{
+					requests.emplace_back(formID.GetUInt(), count.GetInt());
+				}
+			}
+
+			// Repeated forms are folded together so each object is only added once
+			std::sort(requests.begin(), requests.end());
+			std::vector<std::pair<RE::TESBoundObject*, std::int32_t>> objects;
+			for (auto iter = requests.begin(); iter != requests.end();)
+			{
+				auto formID = iter->first;
+				std::int64_t count{ 0 };
+				for (; iter != requests.end() && iter->first == formID; ++iter)
+				{
+					count += iter->second;
+				}
+
+				auto form = RE::TESForm::GetFormByID(formID);
+				if (form && FormRegistry::IsInventoryType(form->GetFormType()))
+				{
+					if (auto object = form->As<RE::TESBoundObject>(); object)
 					{
-						auto textFormID = fmt::format(FMT_STRING("[{:08X}]"), entry.first);
-
-						RE::Scaleform::GFx::Value listEntry;
-						uiMovie->CreateObject(&listEntry);
-						listEntry.SetMember("text", entry.second.data());
-						listEntry.SetMember("textFormID", textFormID.data());
-						listEntry.SetMember("FormID", entry.first);
-						a_value.PushBack(listEntry);
+						objects.emplace_back(object, static_cast<std::int32_t>(std::min<std::int64_t>(count, std::numeric_limits<std::int32_t>::max())));
 					}
-				};
+				}
+			}
+
+			if (objects.empty())
+			{
+				return;
+			}
+
+			std::int64_t total{ 0 };
+			auto PlayerCharacter = RE::PlayerCharacter::GetSingleton();
+			for (auto& [object, count] : objects)
+			{
+				PlayerCharacter->AddObjectToContainer(object, nullptr, count, nullptr, RE::ITEM_REMOVE_REASON::kNone);
+				total += count;
+			}
+
+			auto message = FormatItemsAdded(total);
+			RE::SendHUDMessage::ShowHUDMessage(message.data(), nullptr, false, false);
+			logger::debug(FMT_STRING("PluginExplorer: Added {:d} items from {:d} forms."), total, objects.size());
+		}
+
+		// The GMST can be replaced by a translation, one that fmt cannot format with the count falls back to the default
+		static std::string FormatItemsAdded(std::int64_t a_total)
+		{
+			try
+			{
+				return fmt::format(fmt::runtime(Forms::sBakaItemsAdded.GetString()), a_total);
+			}
+			catch (const fmt::format_error& e)
+			{
+				logger::warn(FMT_STRING("PluginExplorer: Invalid sBakaItemsAdded format: {:s}"), e.what());
+				return fmt::format(FMT_STRING("{:d} items added"), a_total);
+			}
+		}
+
+		// Lists every plugin touching a form in load order, starting with the one it originates from
+		void GetFormOverrides(std::uint32_t a_plugin, std::string_view a_category, std::uint32_t a_formID)
+		{
+			auto& names = FormIndex::CATEGORY_NAMES;
+			auto name = std::find(names.begin(), names.end(), a_category);
+			if (!snapshot || a_plugin >= snapshot->GetPluginList().size() || name == names.end())
+			{
+				return;
+			}
+
+			auto pluginList = snapshot->GetPluginList();
+			auto forms = pluginList[a_plugin].GetForms(static_cast<FormCategory>(name - names.begin()));
+			auto pos = forms.position(a_formID);
+			if (!pos)
+			{
+				return;
+			}
+
+			RE::Scaleform::GFx::Value args[2];
+			args[0] = a_formID;
+			uiMovie->CreateArray(&args[1]);
 
-				auto ProcessMISCs = [&](RE::Scaleform::GFx::Value& a_misc, RE::Scaleform::GFx::Value& a_junk, RE::Scaleform::GFx::Value& a_mods, const PluginExplorer::PluginInfo::FormMap a_map)
+			auto AddPlugin = [&](std::uint32_t a_index)
+			{
+				auto key = pluginList[a_index].GetKey();
+				auto pluginIndex = FormLabel::Plugin(key.GetCompileIndex(), key.GetLightIndex());
+
+				RE::Scaleform::GFx::Value listEntry;
+				uiMovie->CreateObject(&listEntry);
+				listEntry.SetMember("text", pluginList[a_index].GetName().data());
+				listEntry.SetMember("textFormID", pluginIndex.c_str());
+				listEntry.SetMember("PluginIndex", a_index);
+				args[1].PushBack(listEntry);
+			};
+
+			AddPlugin(a_plugin);
+			for (auto overrider : forms.overrides_of(*pos))
+			{
+				AddPlugin(overrider);
+			}
+
+			menuObj.Invoke("SetFormOverrides", nullptr, args, 2);
+		}
+
+		// Takes an array of { Stat, Min, Max } objects, a missing bound leaves that side of the range open.
+		// Matches across every plugin are sent a page at a time, in index order.
+		void QueryForms(std::string_view a_category, const RE::Scaleform::GFx::Value& a_predicates, std::uint32_t a_page)
+		{
+			auto& names = FormIndex::CATEGORY_NAMES;
+			auto name = std::find(names.begin(), names.end(), a_category);
+			if (name == names.end())
+			{
+				return;
+			}
+
+			// Like searches, queries made before the index is ready get an empty page back
+			if (!snapshot || !snapshot->IsComplete())
+			{
+				RE::Scaleform::GFx::Value args[4];
+				args[0] = name->data();
+				args[1] = a_page;
+				args[2] = 0u;
+				uiMovie->CreateArray(&args[3]);
+				menuObj.Invoke("SetQueryResults", nullptr, args, 4);
+				return;
+			}
+
+			FormQuery query;
+			for (std::uint32_t i = 0; i < a_predicates.GetArraySize(); i++)
+			{
+				RE::Scaleform::GFx::Value predicate, stat;
+				if (!a_predicates.GetElement(i, &predicate) || !predicate.IsObject() ||
+					!predicate.GetMember("Stat", &stat) || !stat.IsString())
+				{
+					continue;
+				}
+
+				auto& statNames = FormIndex::STAT_NAMES;
+				auto statName = std::find(statNames.begin(), statNames.end(), std::string_view{ stat.GetString() });
+				if (statName != statNames.end())
+				{
+					query.Add(
+						static_cast<FormStat>(statName - statNames.begin()),
+						GetBound(predicate, "Min", -std::numeric_limits<float>::infinity()),
+						GetBound(predicate, "Max", std::numeric_limits<float>::infinity()));
+				}
+			}
+
+			auto category = static_cast<FormCategory>(name - names.begin());
+			auto& formIndex = snapshot->GetFormIndex();
+			auto forms = formIndex.GetForms(category);
+			auto start = std::chrono::steady_clock::now();
+			auto matches = query.Run(forms);
+			auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+			logger::debug(
+				FMT_STRING("PluginExplorer: Queried {:d} {:s} forms on {:d} stats in {:d}us ({:d} matches)"),
+				forms.size(),
+				a_category,
+				query.GetPredicates().size(),
+				elapsed.count(),
+				matches.size());
+
+			RE::Scaleform::GFx::Value args[4];
+			args[0] = name->data();
+			args[1] = a_page;
+			args[2] = static_cast<std::uint32_t>(matches.size());
+			uiMovie->CreateArray(&args[3]);
+
+			auto first = std::min(std::size_t{ a_page } * SEARCH_PAGE_SIZE, matches.size());
+			auto last = std::min(first + SEARCH_PAGE_SIZE, matches.size());
+			for (auto i = first; i < last; i++)
+			{
+				auto pos = matches[i];
+				auto entry = forms[pos];
+				auto textFormID = FormLabel::FormID(entry.first);
+
+				RE::Scaleform::GFx::Value listEntry;
+				uiMovie->CreateObject(&listEntry);
+				listEntry.SetMember("text", entry.second.data());
+				listEntry.SetMember("textFormID", textFormID.c_str());
+				listEntry.SetMember("FormID", entry.first);
+				listEntry.SetMember("PluginIndex", formIndex.GetPlugin(category, pos));
+				// Stats the form has no component for are left undefined rather than sent as NaN
+				for (std::uint32_t stat = 0; stat < FormIndex::STAT_COUNT; stat++)
 				{
-					uiMovie->CreateArray(&a_misc);
-					uiMovie->CreateArray(&a_junk);
-					uiMovie->CreateArray(&a_mods);
-					for (auto& entry : a_map)
+					if (auto value = forms.stat(static_cast<FormStat>(stat), pos); !std::isnan(value))
 					{
-						auto textFormID = fmt::format(FMT_STRING("[{:08X}]"), entry.first);
-						if (auto form = RE::TESForm::GetFormByID(entry.first); form)
-						{
-							if (auto misc = form->As<RE::TESObjectMISC>(); misc)
-							{
-								RE::Scaleform::GFx::Value listEntry;
-								uiMovie->CreateObject(&listEntry);
-								listEntry.SetMember("text", entry.second.data());
-								listEntry.SetMember("textFormID", textFormID.data());
-								listEntry.SetMember("FormID", entry.first);
-
-								if (misc->componentData && misc->componentData->size() > 0)
-								{
-									a_junk.PushBack(listEntry);
-								}
-								else if (misc->IsLooseMod())
-								{
-									a_mods.PushBack(listEntry);
-								}
-								else
-								{
-									a_misc.PushBack(listEntry);
-								}
-							}
-						}
+						listEntry.SetMember(FormIndex::STAT_NAMES[stat].data(), static_cast<double>(value));
 					}
-				};
+				}
+
+				args[3].PushBack(listEntry);
+			}
+
+			menuObj.Invoke("SetQueryResults", nullptr, args, 4);
+		}
+
+		static float GetBound(const RE::Scaleform::GFx::Value& a_predicate, const char* a_name, float a_default)
+		{
+			RE::Scaleform::GFx::Value bound;
+			if (!a_predicate.GetMember(a_name, &bound))
+			{
+				return a_default;
+			}
+
+			if (bound.IsNumber())
+			{
+				return static_cast<float>(bound.GetNumber());
+			}
+
+			if (bound.IsInt())
+			{
+				return static_cast<float>(bound.GetInt());
+			}
+
+			if (bound.IsUInt())
+			{
+				return static_cast<float>(bound.GetUInt());
+			}
+
+			return a_default;
+		}
+
+		// Takes "JSONL" or "Binary", the file is written next to the index cache
+		void ExportIndex(std::string_view a_format)
+		{
+			auto& formats = FormIndexExport::FORMAT_NAMES;
+			auto format = std::find(formats.begin(), formats.end(), a_format);
+			if (!snapshot || !snapshot->IsComplete() || format == formats.end())
+			{
+				return;
+			}
+
+			auto exportFormat = static_cast<FormIndexExport::Format>(format - formats.begin());
+			auto count = PluginExplorer::Export(*snapshot, exportFormat);
+			auto path = PluginExplorer::GetExportPath(exportFormat).string();
+
+			RE::Scaleform::GFx::Value args[3];
+			args[0] = count.has_value();
+			args[1] = static_cast<double>(count.value_or(0));
+			args[2] = path.c_str();
+			menuObj.Invoke("SetExportResult", nullptr, args, 3);
+		}
 
-				RE::Scaleform::GFx::Value WEAP, ARMO, ALCH, MISC, JUNK, MODS, HOLO, BOOK, KEYS, AMMO;
-				ProcessForms(WEAP, iter.second.GetMapWEAP());
-				ProcessForms(ARMO, iter.second.GetMapARMO());
-				ProcessForms(ALCH, iter.second.GetMapALCH());
-				ProcessForms(HOLO, iter.second.GetMapHOLO());
-				ProcessForms(BOOK, iter.second.GetMapBOOK());
-				ProcessForms(KEYS, iter.second.GetMapKEYS());
-				ProcessForms(AMMO, iter.second.GetMapAMMO());
-				ProcessMISCs(MISC, JUNK, MODS, iter.second.GetMapMISC());
+		void GetIndexStats()
+		{
+			auto stats = PluginExplorer::GetStats();
+
+			RE::Scaleform::GFx::Value Stats[1];
+			uiMovie->CreateObject(&Stats[0]);
+			Stats[0].SetMember("Generation", stats.generation);
+			Stats[0].SetMember("Snapshots", static_cast<double>(stats.liveSnapshots));
+			Stats[0].SetMember("Bytes", static_cast<double>(stats.liveBytes));
+			Stats[0].SetMember("Forms", static_cast<double>(stats.formCount));
+			Stats[0].SetMember("Plugins", static_cast<double>(stats.pluginCount));
+			Stats[0].SetMember("Complete", stats.complete);
+			Stats[0].SetMember("State", PluginExplorer::STATE_NAMES[stl::to_underlying(stats.state)].data());
+			menuObj.Invoke("SetIndexStats", nullptr, Stats, 1);
+		}
 
-				std::string pluginIndex =
-					(iter.first >= 0xFE) ? fmt::format(FMT_STRING("[FE][{:03X}]"), iter.first - 0xFE) : fmt::format(FMT_STRING("[{:02X}]"), iter.first);
+		void ProcessForms(RE::Scaleform::GFx::Value& a_value, std::uint32_t a_plugin, PluginExplorer::FormList a_forms)
+		{
+			uiMovie->CreateArray(&a_value);
+			for (std::uint32_t pos = 0; pos < a_forms.size(); pos++)
+			{
+				auto entry = a_forms[pos];
+				auto overrides = a_forms.overrides_of(pos);
+				auto textFormID = FormLabel::FormID(entry.first);
 
 				RE::Scaleform::GFx::Value listEntry;
 				uiMovie->CreateObject(&listEntry);
-				listEntry.SetMember("text", iter.second.GetName().data());
-				listEntry.SetMember("textFormID", pluginIndex.data());
-				listEntry.SetMember("WEAP", WEAP);
-				listEntry.SetMember("ARMO", ARMO);
-				listEntry.SetMember("ALCH", ALCH);
-				listEntry.SetMember("MISC", MISC);
-				listEntry.SetMember("JUNK", JUNK);
-				listEntry.SetMember("MODS", MODS);
-				listEntry.SetMember("HOLO", HOLO);
-				listEntry.SetMember("BOOK", BOOK);
-				listEntry.SetMember("KEYS", KEYS);
-				listEntry.SetMember("AMMO", AMMO);
-				PluginList[0].PushBack(listEntry);
+				listEntry.SetMember("text", entry.second.data());
+				listEntry.SetMember("textFormID", textFormID.c_str());
+				listEntry.SetMember("FormID", entry.first);
+				listEntry.SetMember("OverriddenBy", overrides.empty() ? a_plugin : overrides.back());
+				listEntry.SetMember("PluginCount", static_cast<std::uint32_t>(overrides.size() + 1));
+				a_value.PushBack(listEntry);
 			}
+		}
 
-			menuObj.Invoke("SetPluginList", nullptr, PluginList, 1);
+		void UpdateLoadingProgress()
+		{
+			auto progress = WaitingForIndex ? static_cast<std::uint32_t>(PluginExplorer::GetProgress() * 100.0F) : 100;
+			if (progress != LoadingProgress)
+			{
+				LoadingProgress = progress;
+
+				RE::Scaleform::GFx::Value Progress[1];
+				Progress[0] = LoadingProgress;
+				menuObj.Invoke("SetLoadingProgress", nullptr, Progress, 1);
+			}
+		}
+
+		// Tells the movie whether the index is still building, ready, or will not arrive
+		void UpdateIndexState()
+		{
+			auto state = PluginExplorer::GetState();
+			if (state != IndexState)
+			{
+				IndexState = state;
+
+				RE::Scaleform::GFx::Value State[1];
+				State[0] = PluginExplorer::STATE_NAMES[stl::to_underlying(state)].data();
+				menuObj.Invoke("SetIndexState", nullptr, State, 1);
+			}
 		}
 
 		RE::msvc::unique_ptr<RE::BSGFxShaderFXTarget> LPaneBackground_mc{ nullptr };
 		RE::msvc::unique_ptr<RE::BSGFxShaderFXTarget> RPaneBackground_mc{ nullptr };
 		RE::msvc::unique_ptr<RE::BSGFxShaderFXTarget> TPaneBackground_mc{ nullptr };
+		std::shared_ptr<const PluginExplorer::Snapshot> snapshot{ nullptr };
+		std::map<std::pair<std::uint32_t, std::string>, RE::Scaleform::GFx::Value> PluginForms;
+		FormSearch::Results SearchResults;
+		std::uint32_t LoadingProgress{ 0 };
+		std::optional<PluginExplorer::State> IndexState;
+		bool WaitingForIndex{ false };
 		static inline bool IsLoaded{ false };
 	};
 }
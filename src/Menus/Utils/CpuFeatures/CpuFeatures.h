@@ -0,0 +1,58 @@
+#pragma once
+
+namespace Menus::Utils
+{
+	// The widest vector path both the processor and the OS support, detected once and shared by every scanner
+	class CpuFeatures
+	{
+	public:
+		enum class Path : std::uint32_t
+		{
+			kScalar,
+			kSSE2,
+			kAVX2
+		};
+
+		static Path GetPath() noexcept
+		{
+			static const Path path = DetectPath();
+			return path;
+		}
+
+		static std::string_view GetPathName(Path a_path) noexcept
+		{
+			switch (a_path)
+			{
+				case Path::kAVX2:
+					return "AVX2"sv;
+				case Path::kSSE2:
+					return "SSE2"sv;
+				default:
+					return "Scalar"sv;
+			}
+		}
+
+	private:
+		static Path DetectPath() noexcept
+		{
+			int info[4]{};
+			__cpuidex(info, 0, 0);
+			auto maxLeaf = info[0];
+
+			__cpuidex(info, 1, 0);
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+			if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+			{
+				__cpuidex(info, 7, 0);
+				if (info[1] & (1 << 5))
+				{
+					return Path::kAVX2;
+				}
+			}
+
+			// Every x64 processor has SSE2
+			return Path::kSSE2;
+		}
+	};
+}
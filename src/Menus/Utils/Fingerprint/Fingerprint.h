@@ -0,0 +1,134 @@
+#pragma once
+
+namespace Menus::Utils
+{
+	// FNV-1a over the state a cache file was built from, so caches kept on disk can tell when the game data changed under them
+	class Fingerprint
+	{
+	public:
+		// The names the fingerprint is taken over, copied out of the game so the files behind them can be checked off
+		// its thread. Stating every plugin, archive and string table is the slow part.
+		struct Sources
+		{
+			struct Plugin
+			{
+				std::string name;
+				std::uint8_t compileIndex{ 0 };
+				std::uint16_t smallFileCompileIndex{ 0 };
+			};
+
+			// Reads the load order and settings, so it has to run on the game's thread
+			[[nodiscard]] static Sources Capture()
+			{
+				Sources result;
+				for (auto file : RE::TESDataHandler::GetSingleton()->files)
+				{
+					if (file->IsActive())
+					{
+						result.plugins.push_back({ std::string{ file->GetFilename() }, file->GetCompileIndex(), file->GetSmallFileCompileIndex() });
+					}
+				}
+
+				result.language = GetINIString("sLanguage:General"sv);
+				result.archiveLists = {
+					std::string{ GetINIString("sResourceStartUpArchiveList:Archive"sv) },
+					std::string{ GetINIString("sResourceArchiveList:Archive"sv) },
+					std::string{ GetINIString("sResourceArchiveList2:Archive"sv) }
+				};
+				return result;
+			}
+
+			std::vector<Plugin> plugins;
+			std::string language;
+			std::array<std::string, 3> archiveLists;
+		};
+
+		void Add(std::string_view a_string) noexcept
+		{
+			Add(a_string.data(), a_string.size());
+			Add(std::uint64_t{ a_string.size() });
+		}
+
+		void Add(std::uint64_t a_value) noexcept
+		{
+			Add(std::addressof(a_value), sizeof(a_value));
+		}
+
+		void AddFile(const std::filesystem::path& a_path)
+		{
+			std::error_code ec;
+			auto size = std::filesystem::file_size(a_path, ec);
+			Add(ec ? std::uint64_t{ 0 } : size);
+
+			auto time = std::filesystem::last_write_time(a_path, ec);
+			Add(ec ? std::uint64_t{ 0 } : static_cast<std::uint64_t>(time.time_since_epoch().count()));
+		}
+
+		// Any change to the active files, their order or their contents changes the fingerprint
+		void AddLoadOrder(const Sources& a_sources)
+		{
+			for (auto& plugin : a_sources.plugins)
+			{
+				Add(plugin.name);
+				Add(std::uint64_t{ plugin.compileIndex });
+				Add(std::uint64_t{ plugin.smallFileCompileIndex });
+				AddFile(std::filesystem::path{ "Data" } / plugin.name);
+			}
+		}
+
+		// Localized plugins take their names from string tables, which follow the language setting and can be
+		// replaced without touching the plugin, either loose or inside an archive
+		void AddStrings(const Sources& a_sources)
+		{
+			Add(a_sources.language);
+
+			for (std::string_view list : a_sources.archiveLists)
+			{
+				Add(list);
+				for (std::size_t pos = 0; pos < list.size();)
+				{
+					auto end = std::min(list.find(',', pos), list.size());
+					auto first = list.find_first_not_of(' ', pos);
+					if (first < end)
+					{
+						auto last = list.find_last_not_of(' ', end - 1);
+						AddFile(std::filesystem::path{ "Data" } / list.substr(first, last - first + 1));
+					}
+
+					pos = end + 1;
+				}
+			}
+
+			for (auto& plugin : a_sources.plugins)
+			{
+				auto stem = std::filesystem::path{ plugin.name }.stem().string();
+				AddFile(std::filesystem::path{ "Data" } / fmt::format(FMT_STRING("{:s} - Main.ba2"), stem));
+				for (auto extension : { "STRINGS"sv, "DLSTRINGS"sv, "ILSTRINGS"sv })
+				{
+					AddFile(std::filesystem::path{ "Data/Strings" } / fmt::format(FMT_STRING("{:s}_{:s}.{:s}"), stem, a_sources.language, extension));
+				}
+			}
+		}
+
+		[[nodiscard]] std::uint64_t Get() const noexcept { return hash; }
+
+	private:
+		static std::string_view GetINIString(std::string_view a_name)
+		{
+			auto setting = RE::INISettingCollection::GetSingleton()->GetSetting(a_name);
+			return setting ? setting->GetString() : ""sv;
+		}
+
+		void Add(const void* a_data, std::size_t a_size) noexcept
+		{
+			auto bytes = static_cast<const std::uint8_t*>(a_data);
+			for (std::size_t i = 0; i < a_size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= 0x100000001B3;
+			}
+		}
+
+		std::uint64_t hash{ 0xCBF29CE484222325 };
+	};
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Menus/Utils/CpuFeatures/CpuFeatures.h"
+#include "Menus/Utils/Fingerprint/Fingerprint.h"
 #include "Menus/Utils/InventoryItemDisplayData/InventoryItemDisplayData.h"
 #include "Menus/Utils/ItemCard/ItemCard.h"
 #include "Menus/Utils/ItemSorter/ItemSorter.h"
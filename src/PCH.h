@@ -4,13 +4,19 @@
 #include "F4SE/F4SE.h"
 #include "RE/Fallout.h"
 
+#include <bit>
+#include <chrono>
 #include <fstream>
+#include <intrin.h>
+#include <numeric>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 #include <AutoTOML.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <fmt/format.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #pragma warning(pop)
@@ -5,6 +5,7 @@ class Settings
 public:
 	using ISetting = AutoTOML::ISetting;
 	using bSetting = AutoTOML::bSetting;
+	using iSetting = AutoTOML::iSetting;
 
 	static void Load()
 	{
@@ -39,6 +40,11 @@ public:
 
 	static inline bSetting EnableDebugLogging{ "General"s, "EnableDebugLogging"s, false };
 
+	static inline iSetting ExplorerIndexThreads{ "PluginExplorer"s, "IndexThreads"s, 0 };
+	static inline bSetting EnableExplorerIndexCache{ "PluginExplorer"s, "EnableIndexCache"s, true };
+
+	static inline bSetting EnablePerkIconCache{ "LevelUpMenu"s, "EnableIconCache"s, true };
+
 private:
 	Settings() = delete;
 	Settings(const Settings&) = delete;
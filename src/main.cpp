@@ -18,13 +18,19 @@ void F4SEMessageHandler(F4SE::MessagingInterface::Message* a_msg)
 					// Register Menus
 					Menus::Register();
 
-					// Initialize PluginExplorer data
+					// Build the perk graph used by LevelUpMenu
+					Menus::PerkManager::Initialize();
+
+					// Build PluginExplorer data in the background
 					Menus::PluginExplorer::Initialize();
 				}
 				else
 				{
 					logger::debug("GameDataReady - Unloaded"sv);
 
+					// Reset PerkManager data
+					Menus::PerkManager::Reset();
+
 					// Reset PluginExplorer data
 					Menus::PluginExplorer::Reset();
 				}